@@ -1,4 +1,7 @@
 #include "ofApp.h"
+#include "depthPooling.h"
+#include "depthView.h"
+#include "meshKernels.h"
 #include <string>
 #include <iostream>
 
@@ -14,6 +17,10 @@ namespace {
 	auto maxRawDepth = 2.0;
 	auto minMappedDepth = 1;
 	auto maxMappedDepth = 1000;
+	bool parallelBuild = true;
+	DepthPooling depthPooling = DepthPooling::Point;
+	bool incrementalUpdates = false;
+	int changeThreshold = 10; // mm
 	int stepSize = 10;
 
 	typedef std::pair <std::string, ofPrimitiveMode> primativePair;
@@ -32,121 +39,225 @@ namespace {
 
 //--------------------------------------------------------------
 void ofApp::setup() {
-	rs2_pipe.start();
+	workerPool = std::make_unique<WorkerPool>(options.threads);
+	depthCapture.setProfiler(&profiler);
+	depthCapture.start(createDepthSource(options.depthSource));
+	if (!options.record.empty())
+		depthRecorder.start(options.record);
+	if (options.headless)
+		return; // no GL context to set up, only the geometry pipeline runs
 	ofSetVerticalSync(true);
 
 	ofEnableDepthTest();
-	glEnable(GL_POINT_SMOOTH); // use circular points instead of square points
-	glPointSize(3); // make the points bigger
-
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
-
-	meshes.clear();
-
-	// Block program until frames arrive
-	rs2::frameset frames = rs2_pipe.wait_for_frames();
-	// Try to get a frame of a depth image
-	rs2::depth_frame depth = frames.get_depth_frame();
-
-	// loop through the image in the x and y axes
-	for (int y = 0 + buffer; y < depthFrameHeight - buffer; y += stepSize) {
-
-		int vertCounter = 0;
-		auto scanLine = std::make_unique<ofMesh>();
-		scanLine->setMode(primativeModeIterator->second);
-		scanLine->enableIndices();
-
-		for (int x = 0 + buffer; x < depthFrameWidth - buffer; x += stepSize) {
-
-			const ofColor pointColor = ofColor::orange;
-			auto depthValue = depth.get_distance(x, y);
-
-			// map depthValue to extrude it a bit
-			auto extrudedDepthValue = ofMap(depthValue, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, false);
-			scanLine->addColor(pointColor);
-
-			// arbitrarilly set outlier point to `minMappedDepth - 1` as a signal it needs to be interpolated.
-			if (enableNoiseSmoothing && (extrudedDepthValue < minMappedDepth || extrudedDepthValue > maxMappedDepth))
-			{
-				extrudedDepthValue = minMappedDepth - 1; // -1 to bypass any weird float comparision.
-			}
-
-			glm::vec3 pos(x, y, extrudedDepthValue);
-			scanLine->addVertex(pos);
-			scanLine->addIndex(vertCounter);
-			vertCounter++;
+	// Pick up the newest depth frame from the capture thread.
+	// If none arrived since the last update keep drawing the current mesh.
+	rs2::frame frame = depthCapture.getLatestFrame();
+	if (!frame)
+		return;
+	rs2::depth_frame depth = frame;
+	depthRecorder.add(depth);
+
+	processedFrames++;
+	if (options.frames > 0 && processedFrames >= options.frames)
+		ofExit();
+
+	// Raw Z16 samples are mapped to extruded depth a row at a time by a SIMD kernel.
+	depthExtrusion.depthUnits = depth.get_units();
+	depthExtrusion.minRawDepth = minRawDepth;
+	depthExtrusion.maxRawDepth = maxRawDepth;
+	depthExtrusion.minMappedDepth = minMappedDepth;
+	depthExtrusion.maxMappedDepth = maxMappedDepth;
+	const auto depthView = DepthView::fromFrame(depth);
+
+	// All scanlines live in one mesh that is only reallocated when stepSize changes
+	// the grid shape. Every other frame positions are overwritten in place.
+	DepthSampling sampling;
+	// at most depthFrameWidth x depthFrameHeight; smaller sources are sampled whole
+	sampling.width = std::min(depthView.width, depthFrameWidth);
+	sampling.height = std::min(depthView.height, depthFrameHeight);
+	sampling.stepSize = stepSize;
+	sampling.border = buffer;
+
+	const int columns = sampling.getColumns();
+	const int rows = sampling.getRows();
+	if (mesh.allocate(columns, rows))
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Indices);
+		mesh.setColor(ofColor::orange);
+
+		// one run of indices per scanline, separated by a primitive restart so
+		// the whole topography is drawn with a single call in any primitive mode
+		auto& indices = mesh.getIndices();
+		indices.reserve(rows * (columns + 1));
+		for (int row = 0; row < rows; row++) {
+			for (int i = 0; i < columns; i++)
+				indices.push_back(row * columns + i);
+			indices.push_back(GridMesh::restartIndex);
 		}
+		mesh.updateIndices();
+	}
+
+	// Rows are independent, so with parallelBuild they are built in bands on the worker pool.
+	WorkerPool* pool = parallelBuild ? workerPool.get() : nullptr;
+
+	// With depthPooling every stepSize x stepSize block is first reduced to one value (the
+	// min, median or mean of its valid pixels), and everything below reads those instead
+	// of one pixel per block, so dropouts and noise don't alias into the mesh.
+	DepthView sampleView = depthView;
+	if (depthPooling != DepthPooling::Point)
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Downsampling);
+		pooledDepth.resize(columns * rows);
+		poolDepthBlocks(depthView, sampling, depthPooling, pooledDepth.data(), pool);
+		sampleView = DepthView::fromSamples(pooledDepth.data(), columns, rows);
+		sampling.preSampled = true;
+	}
 
-		// Iterate through the completed mesh and interpolate if needed.
+	auto& vertices = mesh.getVertices();
+	if (incrementalUpdates)
+	{
+		// Only the tiles whose depth moved by more than changeThreshold are rebuilt and
+		// re-uploaded, and a frame in which nothing moved is skipped. Smoothing reads
+		// whole scanlines, so with it a change rebuilds every tile of its tile row.
+		ScopedStageTimer timer(profiler, StageProfiler::DepthConversion);
+		if (dirtyTiles.update(sampleView, sampling, depth.get_units(), changeThreshold / 1000.0f, pool) == 0)
+			return;
 		if (enableNoiseSmoothing)
-		{
-			for (int i = 0; i < scanLine->getNumVertices(); i++)
-			{
-				auto targetVert = scanLine->getVertex(i);
-				bool targetVertDirty = false;
-				bool hasPrevVert = (i != 0 ? true : false);
-				bool hasNextVert = (i != (scanLine->getNumVertices() - 1) ? true : false);
-				if (targetVert.z < minMappedDepth) {
-					targetVertDirty = true;
-					auto lerpZ = minMappedDepth;
-					if (hasPrevVert && hasNextVert) {
-						auto prevVertZ = scanLine->getVertex(i - 1).z;
-						auto nextVertZ = scanLine->getVertex(i + 1).z;
-						lerpZ = ofLerp(prevVertZ, nextVertZ, 0.5);
-					}
-					else if (hasPrevVert && !hasNextVert) {
-						lerpZ = scanLine->getVertex(i - 1).z;
-					}
-					else {
-						lerpZ = scanLine->getVertex(i + 1).z;
-					}
-					targetVert.z = lerpZ;
-				}
-				if (targetVertDirty)
-					scanLine->setVertex(i, targetVert);
-			}
-		}
+			dirtyTiles.markDirtyRows();
+		buildScanlines(sampleView, depthExtrusion, sampling, enableNoiseSmoothing, vertices.data(), dirtyTiles, pool);
+	}
+	else
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::DepthConversion);
+		buildScanlines(sampleView, depthExtrusion, sampling, enableNoiseSmoothing, vertices.data(), pool);
+	}
 
-		meshes.push_back(std::move(scanLine));
+	// Iterate through each completed scanline and interpolate if needed.
+	if (enableNoiseSmoothing)
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Smoothing);
+		if (incrementalUpdates)
+			smoothScanlines(vertices.data(), columns, minMappedDepth, dirtyTiles, pool);
+		else
+			smoothScanlines(vertices.data(), columns, rows, minMappedDepth, pool);
 	}
+
+	if (incrementalUpdates)
+		mesh.updateVertices(dirtyTiles);
+	else
+		mesh.updateVertices(columns * rows);
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-	ofBackgroundGradient(ofColor::black, ofColor::black, OF_GRADIENT_CIRCULAR);
-
-	// even points can overlap with each other, let's avoid that
-	cam.begin();
-	//ofScale(2, -2, 2); // flip the y axis
-	//ofRotateYDeg(90);
-	ofRotateZDeg(180);
-	ofRotateXDeg(270);
-	ofTranslate(-appWidth / 4 , 0, -appHeight/4);
-	for (auto& scanLine : meshes) {
-		scanLine->draw();
+	if (options.headless)
+		return;
+
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Upload);
+		mesh.upload();
+	}
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Draw);
+		ofBackgroundGradient(ofColor::black, ofColor::black, OF_GRADIENT_CIRCULAR);
+
+		// even points can overlap with each other, let's avoid that
+		cam.begin();
+		//ofScale(2, -2, 2); // flip the y axis
+		//ofRotateYDeg(90);
+		ofRotateZDeg(180);
+		ofRotateXDeg(270);
+		ofTranslate(-appWidth / 4 , 0, -appHeight/4);
+		// the programmable renderer has no GL_POINT_SMOOTH, a shader draws the points round
+		const bool points = primativeModeIterator->second == OF_PRIMITIVE_POINTS;
+		if (points)
+			roundPoints.begin(mesh.hasColor());
+		mesh.drawElements(primativeModeIterator->second);
+		if (points)
+			roundPoints.end();
+		cam.end();
 	}
-	cam.end();
 
 	// Draw Text
+	ScopedStageTimer timer(profiler, StageProfiler::Hud);
 	stringstream ss;
 	ss << "Point Density (m, n): " << stepSize << std::endl;
 	ss << "minRawDepth (p,o): " << minRawDepth << std::endl;
 	ss << "maxnRawDepth (l,k): " << maxRawDepth << std::endl;
 	ss << "enableNoiseSmoothing (f): " << (enableNoiseSmoothing ? "true" : "false") << std::endl;
 	ss << "primativeMode (x): " << primativeModeIterator->first << std::endl;
+	ss << "parallelBuild (j): " << (parallelBuild ? workerPool->getNumThreads() : 1) << " threads" << std::endl;
+	ss << "depthPooling (b): " << getDepthPoolingName(depthPooling) << std::endl;
+	ss << "extrusion: " << getSimdPathName(getSupportedSimdPath()) << std::endl;
+	ss << "incrementalUpdates (i): " << (incrementalUpdates ? "true" : "false") << std::endl;
+	ss << "changeThreshold (g,h): " << changeThreshold << " mm" << std::endl;
+	ss << "tiles touched: " << ofToString(dirtyTiles.getDirtyFraction() * 100, 1) << "% (avg "
+		<< ofToString(dirtyTiles.getCounters().getDirtyFraction() * 100, 1) << "%), frames skipped: "
+		<< dirtyTiles.getCounters().skippedFrames << "/" << dirtyTiles.getCounters().frames << std::endl;
+	ss << "capture dropped/duplicate: " << depthCapture.getDroppedFrames() << "/" << depthCapture.getDuplicateFrames() << std::endl;
+	ss << "recording (R): " << depthRecorder.getSummary() << std::endl;
 	ofDrawBitmapString(ss.str().c_str(), 20, 20);
+	profiler.draw(400, 20);
+
+}
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+	depthCapture.stop();
+	depthRecorder.stop();
+	ofLogNotice() << processedFrames << " frames from " << depthCapture.getSourceDescription()
+		<< ", " << depthCapture.getDroppedFrames() << " dropped";
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+	// Any setting can change the mesh, so rebuild every tile on the next frame
+	dirtyTiles.invalidate();
+
+	// Toggle recording the depth frames
+	if (key == 'R') {
+		if (depthRecorder.isRecording())
+			depthRecorder.stop();
+		else
+			depthRecorder.start(ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".rsdepth");
+	}
+
 	// Toggle Filtering
 	if (key == 'f')
 		enableNoiseSmoothing = !enableNoiseSmoothing;
 
+	// Toggle the parallel mesh build
+	if (key == 'j')
+		parallelBuild = !parallelBuild;
+
+	// Cycle the block pooling mode
+	if (key == 'b')
+		depthPooling = DepthPooling((int(depthPooling) + 1) % 4);
+
+	// Toggle incremental mesh updates
+	if (key == 'i') {
+		incrementalUpdates = !incrementalUpdates;
+		dirtyTiles.resetCounters();
+	}
+
+	// Increase Decrease changeThreshold
+	if (key == 'h') changeThreshold += 1;
+	if (key == 'g') {
+		if (changeThreshold > 0)
+			changeThreshold -= 1;
+	};
+
+	// Save the stage timings
+	if (key == 'v') {
+		const auto path = "stages_" + ofGetTimestampString() + ".csv";
+		if (profiler.saveCsv(path))
+			ofLogNotice() << "stage timings saved to " << path;
+	}
+
 	// Cycle Primative Mode 
 	if (key == 'x') {
 		// MK NOTE: end() actually returns an iterator referring to the "past-the-end" element.
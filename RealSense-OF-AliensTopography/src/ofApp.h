@@ -2,6 +2,15 @@
 
 #include <librealsense2/rs.hpp>
 #include "ofMain.h"
+#include "appOptions.h"
+#include "depthCapture.h"
+#include "depthExtrusion.h"
+#include "depthRecorder.h"
+#include "dirtyTiles.h"
+#include "gridMesh.h"
+#include "roundPoints.h"
+#include "stageProfiler.h"
+#include "workerPool.h"
 
 class ofApp : public ofBaseApp{
 
@@ -9,6 +18,7 @@ class ofApp : public ofBaseApp{
 		void setup();
 		void update();
 		void draw();
+		void exit();
 
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -22,7 +32,14 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 
-		rs2::pipeline rs2_pipe;
+		AppOptions options;
+		DepthCapture depthCapture;
+		DepthRecorder depthRecorder;
+		StageProfiler profiler;
+		std::unique_ptr<WorkerPool> workerPool;
+		int processedFrames = 0;
+		DepthExtrusion depthExtrusion;
+		std::vector<uint16_t> pooledDepth;
 
 		static const int appWidth;
 		static const int appHeight;
@@ -30,6 +47,7 @@ class ofApp : public ofBaseApp{
 		static const int depthFrameHeight;
 
 		ofEasyCam cam;
-		ofMesh mesh;
-		std::vector<std::unique_ptr<ofMesh>> meshes;
+		GridMesh mesh;
+		RoundPoints roundPoints{ 3 }; // circular points, 3 pixels wide
+		DirtyTiles dirtyTiles;
 };
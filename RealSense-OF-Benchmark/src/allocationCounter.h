@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+// Number of operator new calls made so far, by any thread.
+// The global operator new is replaced in allocationCounter.cpp. The count is
+// shared so the WorkerPool threads of the *_parallel kernels show up too;
+// datasets are captured up front and their source stopped, so librealsense's
+// own threads are idle while the kernels are measured.
+std::size_t getAllocationCount();
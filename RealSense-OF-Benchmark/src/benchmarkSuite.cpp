@@ -0,0 +1,918 @@
+#include "benchmarkSuite.h"
+#include "ofMain.h"
+#include "allocationCounter.h"
+#include "circleBatch.h"
+#include "depthContours.h"
+#include "depthExtrusion.h"
+#include "depthLut.h"
+#include "depthPooling.h"
+#include "depthRecording.h"
+#include "depthRoi.h"
+#include "depthSource.h"
+#include "dirtyTiles.h"
+#include "gridIndexBuffer.h"
+#include "holeFilling.h"
+#include "meshKernels.h"
+#include "quadtreeMesh.h"
+#include "vertexLabels.h"
+#include "workerPool.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace {
+	// The apps' default depth ranges. PointCloud clamps and maps up to 5m,
+	// AliensTopography and TriangleMesh don't clamp and stop at 2m.
+	const float minRawDepth = 0.1f;
+	const float maxRawDepth = 2.0f;
+	const float pointCloudMaxRawDepth = 5.0f;
+	const float minMappedDepth = 1;
+	const float maxMappedDepth = 1000;
+	const float adaptiveTolerance = 4; // TriangleMesh's default
+	const long maxIterations = 1 << 20;
+
+	// Keeps the compiler from throwing the measured loops away.
+	volatile float sink = 0;
+
+	// Runs body(frameIndex) over the dataset's frames in turn, doubling the number
+	// of iterations until they took at least minSeconds. body returns the number
+	// of vertices it produced.
+	template <typename Body>
+	BenchmarkResult measure(const DepthDataset& dataset, const BenchmarkSettings& settings,
+		const std::string& kernel, int stepSize, Body body)
+	{
+		const size_t frameCount = dataset.frames.size();
+		sink = body(0); // warm up caches and lazily sized buffers
+
+		long iterations = 0;
+		long batch = 1;
+		double vertices = 0;
+		std::chrono::steady_clock::duration elapsed{};
+		const size_t allocationsBefore = getAllocationCount();
+		while (iterations < maxIterations) {
+			const auto start = std::chrono::steady_clock::now();
+			for (long i = 0; i < batch; i++) {
+				const int produced = body((iterations + i) % frameCount);
+				vertices += produced;
+				sink = produced;
+			}
+			elapsed += std::chrono::steady_clock::now() - start;
+			iterations += batch;
+			if (std::chrono::duration<double>(elapsed).count() >= settings.minSecondsPerKernel)
+				break;
+			batch *= 2;
+		}
+		const size_t allocations = getAllocationCount() - allocationsBefore;
+
+		BenchmarkResult result;
+		result.dataset = dataset.name;
+		result.width = dataset.width;
+		result.height = dataset.height;
+		result.kernel = kernel;
+		result.stepSize = stepSize;
+		result.iterations = iterations;
+		result.nsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+		result.verticesPerFrame = vertices / iterations;
+		result.allocationsPerFrame = double(allocations) / iterations;
+		return result;
+	}
+
+	// TriangleMesh's smoothing before fillDepthHoles(): after every row the whole
+	// mesh built so far is walked again.
+	void smoothPerRow(glm::vec3* vertices, int columns, int rows)
+	{
+		for (int row = 0; row < rows; row++) {
+			const int vertCounter = (row + 1) * columns;
+			for (int i = 0; i < vertCounter; i++) {
+				auto& targetVert = vertices[i];
+				bool hasPrevVert = (i != 0);
+				bool hasNextVert = (i != (vertCounter - 1));
+				if (targetVert.z < minMappedDepth && (hasPrevVert && hasNextVert))
+					targetVert.z = ofLerp(vertices[i - 1].z, vertices[i + 1].z, 0.5);
+				if (hasPrevVert != hasNextVert)
+					targetVert.z = maxMappedDepth;
+			}
+		}
+	}
+
+	// poolDepthBlocks() without the vectorised row reductions: the valid pixels
+	// of the one block gathered and reduced on their own.
+	uint16_t poolBlockReference(const DepthView& depth, const DepthSampling& sampling, DepthPooling mode, int column, int row)
+	{
+		const int firstX = sampling.border + column * sampling.stepSize;
+		const int firstY = sampling.border + row * sampling.stepSize;
+		if (mode == DepthPooling::Point)
+			return depth.row(firstY)[firstX];
+		const int endX = std::min(sampling.width - sampling.border, firstX + sampling.stepSize);
+		const int endY = std::min(sampling.height - sampling.border, firstY + sampling.stepSize);
+
+		std::vector<uint16_t> values;
+		for (int y = firstY; y < endY; y++) {
+			for (int x = firstX; x < endX; x++) {
+				if (depth.row(y)[x] != 0)
+					values.push_back(depth.row(y)[x]);
+			}
+		}
+		if (values.empty())
+			return 0;
+		switch (mode) {
+		case DepthPooling::Min:
+			return *std::min_element(values.begin(), values.end());
+		case DepthPooling::Median:
+			std::sort(values.begin(), values.end());
+			return values[(values.size() - 1) / 2];
+		default: {
+			uint64_t sum = 0;
+			for (uint16_t value : values)
+				sum += value;
+			return uint16_t((sum + values.size() / 2) / values.size());
+		}
+		}
+	}
+
+	// Pools depth with poolDepthBlocks() and checks every sample against
+	// poolBlockReference().
+	bool matchesPoolingReference(const DepthView& depth, const DepthSampling& sampling, DepthPooling mode)
+	{
+		std::vector<uint16_t> pooled(sampling.getColumns() * sampling.getRows());
+		poolDepthBlocks(depth, sampling, mode, pooled.data());
+		for (int row = 0; row < sampling.getRows(); row++) {
+			for (int column = 0; column < sampling.getColumns(); column++) {
+				if (pooled[row * sampling.getColumns() + column] != poolBlockReference(depth, sampling, mode, column, row))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// A frame whose pixel span is no multiple of the 8 lanes the pooling kernels
+	// use, with dropouts, an all-zero patch and the extreme raw values 1 and
+	// 0xffff that the minimum's wrap-around has to keep apart from 0.
+	std::vector<uint16_t> makePoolingTestFrame(int width, int height)
+	{
+		std::mt19937 random(7);
+		std::vector<uint16_t> pixels(width * height);
+		for (auto& pixel : pixels) {
+			const uint32_t roll = random() % 100;
+			pixel = roll < 20 ? 0 : roll < 23 ? 1 : roll < 26 ? 0xffff : uint16_t(random());
+		}
+		for (int y = height / 4; y < height / 2; y++)
+			std::fill(pixels.begin() + y * width + width / 3, pixels.begin() + y * width + width / 3 + width / 4, 0);
+		return pixels;
+	}
+
+	std::string jsonString(const std::string& value)
+	{
+		std::string quoted = "\"";
+		for (char c : value) {
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+}
+
+//--------------------------------------------------------------
+DepthView DepthDataset::getView(size_t frameIndex) const
+{
+	DepthView view;
+	view.data = frames[frameIndex].data();
+	view.width = width;
+	view.height = height;
+	view.stride = width;
+	return view;
+}
+
+DepthDataset captureDataset(const std::string& description, int frameCount, int warmupFrames)
+{
+	DepthDataset dataset;
+	auto source = createDepthSource(description);
+	dataset.name = source->getDescription();
+	source->start();
+
+	int skipped = 0;
+	while (int(dataset.frames.size()) < frameCount) {
+		rs2::frame frame = source->waitForFrame(5000);
+		if (!frame) {
+			ofLogError("captureDataset") << "no frame from " << dataset.name << " within 5s";
+			break;
+		}
+		if (skipped++ < warmupFrames)
+			continue;
+
+		rs2::depth_frame depth = frame;
+		const auto view = DepthView::fromFrame(depth);
+		dataset.width = view.width;
+		dataset.height = view.height;
+		dataset.depthUnits = depth.get_units();
+
+		std::vector<uint16_t> pixels(view.width * view.height);
+		for (int y = 0; y < view.height; y++)
+			std::copy(view.row(y), view.row(y) + view.width, pixels.begin() + y * view.width);
+		dataset.frames.push_back(std::move(pixels));
+		if (!dataset.firstFrame)
+			dataset.firstFrame = frame;
+	}
+
+	source->stop();
+	return dataset;
+}
+
+//--------------------------------------------------------------
+std::vector<BenchmarkResult> runBenchmarks(const DepthDataset& dataset, const BenchmarkSettings& settings)
+{
+	std::vector<BenchmarkResult> results;
+	if (dataset.frames.empty())
+		return results;
+
+	DepthExtrusion extrusion;
+	extrusion.depthUnits = dataset.depthUnits;
+	extrusion.minRawDepth = minRawDepth;
+	extrusion.maxRawDepth = maxRawDepth;
+	extrusion.minMappedDepth = minMappedDepth;
+	extrusion.maxMappedDepth = maxMappedDepth;
+	DepthExtrusion pointCloudExtrusion = extrusion;
+	pointCloudExtrusion.maxRawDepth = pointCloudMaxRawDepth;
+	pointCloudExtrusion.clamp = true;
+	pointCloudExtrusion.exclusiveRange = true;
+
+	// the table lookup the SIMD kernel replaced, for extrude_lut
+	DepthLut depthLut;
+	depthLut.update(dataset.depthUnits, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, false);
+	std::vector<SimdPath> simdPaths = { SimdPath::Scalar };
+	for (auto path : { SimdPath::Sse41, SimdPath::Avx2 }) {
+		if (path <= getSupportedSimdPath())
+			simdPaths.push_back(path);
+	}
+	const rs2::depth_frame depth = dataset.firstFrame;
+
+	// pools of 2, 4, 8 .. threads up to settings.threads, to see how the parallel build scales
+	std::vector<std::unique_ptr<WorkerPool>> pools;
+	const int maxThreads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+	for (int threads = 2; threads < maxThreads; threads *= 2)
+		pools.push_back(std::make_unique<WorkerPool>(threads));
+	if (maxThreads > 1)
+		pools.push_back(std::make_unique<WorkerPool>(maxThreads));
+
+	for (int stepSize = settings.minStepSize; stepSize <= settings.maxStepSize; stepSize++) {
+		DepthSampling sampling;
+		sampling.width = dataset.width;
+		sampling.height = dataset.height;
+		sampling.stepSize = stepSize;
+		const int columns = sampling.getColumns();
+		const int rows = sampling.getRows();
+
+		// storage is sized once per stepSize like the apps' GridMesh, so the
+		// allocation counts show what the kernels themselves allocate
+		std::vector<glm::vec3> vertices(columns * rows);
+		std::vector<float> grid(columns * rows);
+
+		// Z16 to extruded z and validity for every sampled row, through the table
+		// and on each SIMD path
+		std::vector<uint8_t> validity(columns * rows);
+		results.push_back(measure(dataset, settings, "extrude_lut", stepSize, [&](size_t frame) {
+			const auto view = dataset.getView(frame);
+			for (int row = 0; row < rows; row++) {
+				const uint16_t* depthRow = view.row(row * stepSize);
+				for (int column = 0; column < columns; column++) {
+					const float z = depthLut[depthRow[column * stepSize]];
+					grid[row * columns + column] = z;
+					validity[row * columns + column] = z >= minMappedDepth && z <= maxMappedDepth;
+				}
+			}
+			return columns * rows;
+		}));
+		for (auto path : simdPaths) {
+			results.push_back(measure(dataset, settings, std::string("extrude_") + getSimdPathName(path), stepSize, [&](size_t frame) {
+				const auto view = dataset.getView(frame);
+				for (int row = 0; row < rows; row++)
+					extrudeDepthRow(view.row(row * stepSize), columns, stepSize, extrusion, &grid[row * columns], &validity[row * columns], path);
+				return columns * rows;
+			}));
+		}
+
+		// block pooling ahead of the kernels, in place of reading one pixel per block,
+		// checked block by block against a plain reduction on every frame and on a
+		// frame with an odd span, a border, dropouts and all-zero blocks
+		std::vector<uint16_t> pooled(columns * rows);
+		const int oddWidth = 101, oddHeight = 37;
+		const auto oddFrame = makePoolingTestFrame(oddWidth, oddHeight);
+		DepthSampling oddSampling = sampling;
+		oddSampling.width = oddWidth;
+		oddSampling.height = oddHeight;
+		oddSampling.border = 2;
+		for (auto mode : { DepthPooling::Min, DepthPooling::Median, DepthPooling::Mean }) {
+			auto result = measure(dataset, settings, std::string("pool_") + getDepthPoolingName(mode), stepSize, [&](size_t frame) {
+				poolDepthBlocks(dataset.getView(frame), sampling, mode, pooled.data());
+				return columns * rows;
+			});
+			result.matchesSerial = matchesPoolingReference(DepthView::fromSamples(oddFrame.data(), oddWidth, oddHeight), oddSampling, mode);
+			for (size_t frame = 0; frame < dataset.frames.size() && result.matchesSerial; frame++)
+				result.matchesSerial = matchesPoolingReference(dataset.getView(frame), sampling, mode);
+			results.push_back(result);
+		}
+
+		results.push_back(measure(dataset, settings, "pointcloud", stepSize, [&](size_t frame) {
+			return buildPointCloud(dataset.getView(frame), pointCloudExtrusion, sampling, true, vertices.data());
+		}));
+
+		if (settings.baselines) {
+			results.push_back(measure(dataset, settings, "pointcloud_get_distance", stepSize, [&](size_t) {
+				int numVertices = 0;
+				for (int y = 0; y < sampling.height; y += stepSize) {
+					for (int x = 0; x < sampling.width; x += stepSize) {
+						auto depthValue = depth.get_distance(x, y);
+						auto extrudedDepthValue = ofMap(depthValue, minRawDepth, pointCloudMaxRawDepth, minMappedDepth, maxMappedDepth, true);
+						if (extrudedDepthValue > minMappedDepth && extrudedDepthValue < maxMappedDepth)
+							vertices[numVertices++] = glm::vec3(x, y, extrudedDepthValue);
+					}
+				}
+				return numVertices;
+			}));
+		}
+
+		results.push_back(measure(dataset, settings, "topography", stepSize, [&](size_t frame) {
+			buildScanlines(dataset.getView(frame), extrusion, sampling, true, vertices.data());
+			return columns * rows;
+		}));
+
+		// smoothing works in place, so every iteration starts from a copy of the
+		// marked scanlines of its frame; the copy is part of the time
+		std::vector<std::vector<glm::vec3>> markedScanlines(dataset.frames.size(), std::vector<glm::vec3>(columns * rows));
+		for (size_t frame = 0; frame < dataset.frames.size(); frame++)
+			buildScanlines(dataset.getView(frame), extrusion, sampling, true, markedScanlines[frame].data());
+		results.push_back(measure(dataset, settings, "topography_smoothing", stepSize, [&](size_t frame) {
+			std::copy(markedScanlines[frame].begin(), markedScanlines[frame].end(), vertices.begin());
+			smoothScanlines(vertices.data(), columns, rows, minMappedDepth);
+			return columns * rows;
+		}));
+		markedScanlines.clear();
+
+		results.push_back(measure(dataset, settings, "trianglemesh_grid", stepSize, [&](size_t frame) {
+			sampleDepthGrid(dataset.getView(frame), extrusion, sampling, true, grid.data());
+			depthGridToVertices(grid.data(), sampling, vertices.data());
+			return columns * rows;
+		}));
+
+		std::vector<std::vector<float>> markedGrids(dataset.frames.size(), std::vector<float>(columns * rows));
+		for (size_t frame = 0; frame < dataset.frames.size(); frame++)
+			sampleDepthGrid(dataset.getView(frame), extrusion, sampling, true, markedGrids[frame].data());
+		results.push_back(measure(dataset, settings, "trianglemesh_smoothing", stepSize, [&](size_t frame) {
+			std::copy(markedGrids[frame].begin(), markedGrids[frame].end(), grid.begin());
+			fillDepthHoles(grid.data(), columns, rows, minMappedDepth, maxMappedDepth);
+			return columns * rows;
+		}));
+
+		// the adaptive mesh over the filled grid; its vertices/frame against
+		// trianglemesh_grid's is the saving on this dataset
+		std::vector<std::vector<float>> filledGrids = markedGrids;
+		for (auto& filledGrid : filledGrids)
+			fillDepthHoles(filledGrid.data(), columns, rows, minMappedDepth, maxMappedDepth);
+		QuadtreeMesh quadtree;
+		std::vector<ofIndexType> quadtreeIndices;
+		results.push_back(measure(dataset, settings, "trianglemesh_adaptive", stepSize, [&](size_t frame) {
+			return quadtree.build(filledGrids[frame].data(), sampling, adaptiveTolerance, vertices.data(), quadtreeIndices);
+		}));
+		filledGrids.clear();
+
+		if (settings.baselines) {
+			results.push_back(measure(dataset, settings, "trianglemesh_smoothing_per_row", stepSize, [&](size_t frame) {
+				depthGridToVertices(markedGrids[frame].data(), sampling, vertices.data());
+				smoothPerRow(vertices.data(), columns, rows);
+				return columns * rows;
+			}));
+		}
+		// labelPoints text, which is only re-formatted for vertices that moved
+		// since the frame before
+		std::vector<std::vector<glm::vec3>> frameVertices(markedGrids.size(), std::vector<glm::vec3>(columns * rows));
+		for (size_t frame = 0; frame < markedGrids.size(); frame++)
+			depthGridToVertices(markedGrids[frame].data(), sampling, frameVertices[frame].data());
+		VertexLabels labels;
+		results.push_back(measure(dataset, settings, "trianglemesh_labels", stepSize, [&](size_t frame) {
+			labels.update(frameVertices[frame].data(), columns * rows);
+			return columns * rows;
+		}));
+		frameVertices.clear();
+		markedGrids.clear();
+
+		// what a stepSize or primitive mode change costs; unchanged frames reuse the cache
+		results.push_back(measure(dataset, settings, "trianglemesh_indices", stepSize, [&](size_t) {
+			GridIndexBuffer indices;
+			indices.update(columns, rows, OF_PRIMITIVE_TRIANGLES);
+			return columns * rows;
+		}));
+
+		std::vector<glm::vec3> expected(columns * rows);
+		auto matches = [&](int count) { return std::equal(expected.begin(), expected.begin() + count, vertices.begin()); };
+
+		// Incremental updates with a 0mm threshold: every frame only rebuilds the
+		// tiles that changed since the one before, so the mesh has to end up as a
+		// full rebuild of the last frame. dirty_tiles_static is the cost of a
+		// frame in which nothing changed.
+		DirtyTiles tiles;
+		tiles.update(dataset.getView(0), sampling, dataset.depthUnits, 0);
+		results.push_back(measure(dataset, settings, "dirty_tiles_static", stepSize, [&](size_t) {
+			tiles.update(dataset.getView(0), sampling, dataset.depthUnits, 0);
+			return columns * rows;
+		}));
+
+		const auto lastView = dataset.getView(dataset.frames.size() - 1);
+		auto topographyIncremental = [&](size_t frame) {
+			const auto view = dataset.getView(frame);
+			if (tiles.update(view, sampling, dataset.depthUnits, 0) > 0) {
+				tiles.markDirtyRows();
+				buildScanlines(view, extrusion, sampling, true, vertices.data(), tiles);
+				smoothScanlines(vertices.data(), columns, minMappedDepth, tiles);
+			}
+			return columns * rows;
+		};
+		tiles.invalidate();
+		auto result = measure(dataset, settings, "topography_incremental", stepSize, topographyIncremental);
+		for (size_t frame = 0; frame < dataset.frames.size(); frame++)
+			topographyIncremental(frame);
+		buildScanlines(lastView, extrusion, sampling, true, expected.data());
+		smoothScanlines(expected.data(), columns, rows, minMappedDepth);
+		result.matchesSerial = matches(columns * rows);
+		results.push_back(result);
+
+		std::vector<float> sampledGrid(columns * rows);
+		auto triangleMeshIncremental = [&](size_t frame) {
+			const auto view = dataset.getView(frame);
+			if (tiles.update(view, sampling, dataset.depthUnits, 0) > 0) {
+				sampleDepthGrid(view, extrusion, sampling, true, sampledGrid.data(), tiles);
+				grid = sampledGrid;
+				fillDepthHoles(grid.data(), columns, rows, minMappedDepth, maxMappedDepth);
+				markChangedGridTiles(grid.data(), vertices.data(), tiles);
+				depthGridToVertices(grid.data(), sampling, vertices.data(), tiles);
+			}
+			return columns * rows;
+		};
+		tiles.invalidate();
+		result = measure(dataset, settings, "trianglemesh_incremental", stepSize, triangleMeshIncremental);
+		for (size_t frame = 0; frame < dataset.frames.size(); frame++)
+			triangleMeshIncremental(frame);
+		sampleDepthGrid(lastView, extrusion, sampling, true, grid.data());
+		fillDepthHoles(grid.data(), columns, rows, minMappedDepth, maxMappedDepth);
+		depthGridToVertices(grid.data(), sampling, expected.data());
+		result.matchesSerial = matches(columns * rows);
+		results.push_back(result);
+
+		// The row kernels again on every pool, each checked against the serial
+		// output for the first frame.
+		const auto firstView = dataset.getView(0);
+		for (auto& pool : pools) {
+			WorkerPool* workers = pool.get();
+
+			const int expectedPoints = buildPointCloud(firstView, pointCloudExtrusion, sampling, true, expected.data());
+			result = measure(dataset, settings, "pointcloud_parallel", stepSize, [&](size_t frame) {
+				return buildPointCloud(dataset.getView(frame), pointCloudExtrusion, sampling, true, vertices.data(), workers);
+			});
+			const int points = buildPointCloud(firstView, pointCloudExtrusion, sampling, true, vertices.data(), workers);
+			result.threads = workers->getNumThreads();
+			result.matchesSerial = points == expectedPoints && matches(points);
+			results.push_back(result);
+
+			buildScanlines(firstView, extrusion, sampling, true, expected.data());
+			smoothScanlines(expected.data(), columns, rows, minMappedDepth);
+			result = measure(dataset, settings, "topography_parallel", stepSize, [&](size_t frame) {
+				buildScanlines(dataset.getView(frame), extrusion, sampling, true, vertices.data(), workers);
+				smoothScanlines(vertices.data(), columns, rows, minMappedDepth, workers);
+				return columns * rows;
+			});
+			buildScanlines(firstView, extrusion, sampling, true, vertices.data(), workers);
+			smoothScanlines(vertices.data(), columns, rows, minMappedDepth, workers);
+			result.threads = workers->getNumThreads();
+			result.matchesSerial = matches(columns * rows);
+			results.push_back(result);
+
+			sampleDepthGrid(firstView, extrusion, sampling, true, grid.data());
+			depthGridToVertices(grid.data(), sampling, expected.data());
+			result = measure(dataset, settings, "trianglemesh_grid_parallel", stepSize, [&](size_t frame) {
+				sampleDepthGrid(dataset.getView(frame), extrusion, sampling, true, grid.data(), workers);
+				depthGridToVertices(grid.data(), sampling, vertices.data(), workers);
+				return columns * rows;
+			});
+			sampleDepthGrid(firstView, extrusion, sampling, true, grid.data(), workers);
+			depthGridToVertices(grid.data(), sampling, vertices.data(), workers);
+			result.threads = workers->getNumThreads();
+			result.matchesSerial = matches(columns * rows);
+			results.push_back(result);
+		}
+	}
+
+	if (depth) {
+		results.push_back(measure(dataset, settings, "box2d_roi", 0, [&](size_t) {
+			return averageRoiDistance(depth, 10, 10, 0.1f) > 0 ? 1 : 0;
+		}));
+
+		// the summed-area tables: one pass over the frame, then a 16 x 16 grid of
+		// zones plus the centre window, which has to average like the above.
+		// box2d_roi_sat builds only the mean tables, as calculateDepth() does;
+		// box2d_roi_sat_median also the 8 median bins.
+		const int zones = 16;
+		for (int medianBins : { 0, 8 }) {
+			DepthRoiStats roiStats(0.1f, 4.0f, medianBins);
+			auto result = measure(dataset, settings, medianBins > 0 ? "box2d_roi_sat_median" : "box2d_roi_sat", 0, [&](size_t frame) {
+				const auto view = dataset.getView(frame);
+				roiStats.update(view, dataset.depthUnits);
+				const int zoneWidth = view.width / zones;
+				const int zoneHeight = view.height / zones;
+				int validZones = 0;
+				for (int zone = 0; zone < zones * zones; zone++)
+					validZones += roiStats.query(zone % zones * zoneWidth, zone / zones * zoneHeight, zoneWidth, zoneHeight).validCount > 0;
+				validZones += roiStats.query((view.width - 10) / 2, (view.height - 10) / 2, 10, 10).validCount > 0;
+				return validZones;
+			});
+			roiStats.update(dataset.getView(0), dataset.depthUnits);
+			const float expectedMean = averageRoiDistance(depth, 10, 10, 0.1f);
+			const float mean = roiStats.query((dataset.width - 10) / 2, (dataset.height - 10) / 2, 10, 10).mean;
+			result.matchesSerial = std::isnan(expectedMean) ? std::isnan(mean) : std::abs(mean - expectedMean) <= 1e-5f * expectedMean;
+			results.push_back(result);
+		}
+
+		// the silhouette outlines handed to Box2D, at the default vertex budget
+		DepthContours contours;
+		const ContourSettings contourSettings;
+		results.push_back(measure(dataset, settings, "box2d_contours", contourSettings.stepSize, [&](size_t frame) {
+			contours.update(dataset.getView(frame), dataset.depthUnits, contourSettings);
+			return contours.getNumVertices();
+		}));
+	}
+
+	{
+		// depth recording: the first frame as a keyframe, every other one delta
+		// coded against the one before, rows coded per frame
+		const int width = dataset.width;
+		const int height = dataset.height;
+		const size_t frameCount = dataset.frames.size();
+		std::vector<std::vector<uint8_t>> payloads(frameCount);
+		auto encode = [&](size_t frame) {
+			payloads[frame].clear();
+			DepthRecordingFormat::encodeFrame(dataset.frames[frame].data(),
+				frame > 0 ? dataset.frames[frame - 1].data() : nullptr, width, height, payloads[frame]);
+			return height;
+		};
+		results.push_back(measure(dataset, settings, "recording_encode", 0, encode));
+
+		// measure() visits the frames in order, so each one decodes over the last
+		std::vector<uint16_t> decoded(size_t(width) * height);
+		auto decode = [&](size_t frame) {
+			return DepthRecordingFormat::decodeFrame(payloads[frame].data(), payloads[frame].size(), frame == 0,
+				width, height, decoded.data()) ? height : 0;
+		};
+		auto result = measure(dataset, settings, "recording_decode", 0, decode);
+		for (size_t frame = 0; frame < frameCount && result.matchesSerial; frame++)
+			result.matchesSerial = decode(frame) == height && decoded == dataset.frames[frame];
+		results.push_back(result);
+	}
+	return results;
+}
+
+//--------------------------------------------------------------
+bool verifyDepthExtrusion(std::ostream& out)
+{
+	// every Z16 value, three times over so strided reads stay in bounds
+	std::vector<uint16_t> raw(65536 * 3);
+	for (size_t i = 0; i < raw.size(); i++)
+		raw[i] = uint16_t(i);
+
+	std::vector<DepthExtrusion> extrusions;
+	for (float depthUnits : { 0.001f, 0.0001f, 0.00025f }) {
+		for (bool clamp : { false, true }) {
+			for (bool exclusiveRange : { false, true }) {
+				DepthExtrusion extrusion;
+				extrusion.depthUnits = depthUnits;
+				extrusion.clamp = clamp;
+				extrusion.exclusiveRange = exclusiveRange;
+				extrusions.push_back(extrusion);          // the apps' ranges
+				extrusion.maxRawDepth = 5.0f;
+				extrusions.push_back(extrusion);
+				extrusion.minMappedDepth = 1000;          // reversed output range
+				extrusion.maxMappedDepth = -20;
+				extrusions.push_back(extrusion);
+				extrusion.minRawDepth = extrusion.maxRawDepth; // empty input range
+				extrusions.push_back(extrusion);
+			}
+		}
+	}
+
+	int failures = 0;
+	std::vector<float> expectedZ(65536), z(65536);
+	std::vector<uint8_t> expectedValid(65536), valid(65536);
+	for (const auto& extrusion : extrusions) {
+		DepthLut depthLut;
+		depthLut.update(extrusion.depthUnits, extrusion.minRawDepth, extrusion.maxRawDepth,
+			extrusion.minMappedDepth, extrusion.maxMappedDepth, extrusion.clamp);
+
+		for (int step = 1; step <= 3; step++) {
+			// odd counts leave a scalar tail behind the vector loops
+			for (int count : { 65536, 65531, 7, 1 }) {
+				extrudeDepthRow(raw.data(), count, step, extrusion, expectedZ.data(), expectedValid.data(), SimdPath::Scalar);
+
+				// the scalar path has to be ofMap() itself
+				for (int i = 0; i < count; i++) {
+					const float lutZ = depthLut[raw[i * step]];
+					if (std::memcmp(&lutZ, &expectedZ[i], sizeof(float)) != 0) {
+						out << "scalar differs from ofMap() at raw " << raw[i * step] << ": " << expectedZ[i] << " vs " << lutZ << std::endl;
+						failures++;
+						break;
+					}
+				}
+
+				for (auto path : { SimdPath::Sse41, SimdPath::Avx2 }) {
+					if (path > getSupportedSimdPath())
+						continue;
+					extrudeDepthRow(raw.data(), count, step, extrusion, z.data(), valid.data(), path);
+					if (std::memcmp(z.data(), expectedZ.data(), count * sizeof(float)) != 0 ||
+						std::memcmp(valid.data(), expectedValid.data(), count) != 0) {
+						out << getSimdPathName(path) << " differs from scalar (step " << step << ", count " << count
+							<< ", clamp " << extrusion.clamp << ", exclusiveRange " << extrusion.exclusiveRange << ")" << std::endl;
+						failures++;
+					}
+				}
+			}
+		}
+	}
+
+	out << "depth extrusion: " << extrusions.size() << " parameter sets, best path "
+		<< getSimdPathName(getSupportedSimdPath()) << ", " << failures << " failures" << std::endl;
+	return failures == 0;
+}
+
+//--------------------------------------------------------------
+bool verifyCircleBatch(std::ostream& out)
+{
+	int failures = 0;
+	const ofFloatColor color(0, 0, 1, 1);
+	const ofFloatColor hitColor(1, 0, 0, 1);
+
+	// per slot, the tick before: a body that moves, a hit one, one about to respawn
+	const std::vector<CircleState> previous = {
+		{ glm::vec2(7, 7), 10, 0, false },
+		{ glm::vec2(0, 0), 20, 1, false },
+		{ glm::vec2(100, 0), 30, 2, true },
+		{ glm::vec2(50, 50), 40, 3, false }
+	};
+	// and the current tick: slot 0 parked, slot 3 respawned, slot 4 new since
+	const std::vector<CircleState> current = {
+		{ glm::vec2(9, 9), 10, 0, false },
+		{ glm::vec2(10, 20), 20, 1, false },
+		{ glm::vec2(100, -40), 30, 2, true },
+		{ glm::vec2(5, 5), 15, 7, false },
+		{ glm::vec2(-8, 3), 25, 8, true }
+	};
+	CircleBatch batch;
+	for (float alpha : { 0.0f, 0.5f, 1.0f }) {
+		const std::vector<glm::vec3> expectedCircles = {
+			glm::vec3(10 * alpha, 20 * alpha, 20),
+			glm::vec3(100, -40 * alpha, 30),
+			glm::vec3(5, 5, 15),
+			glm::vec3(-8, 3, 25)
+		};
+		const std::vector<ofFloatColor> expectedColors = { color, hitColor, color, hitColor };
+
+		batch.clear();
+		addInterpolatedCircles(batch, previous, current, alpha, color, hitColor);
+		if (batch.size() != int(expectedCircles.size())) {
+			out << "interpolated circles: " << batch.size() << " at alpha " << alpha
+				<< " instead of " << expectedCircles.size() << std::endl;
+			failures++;
+			continue;
+		}
+		for (int i = 0; i < batch.size(); i++) {
+			if (glm::distance(batch.getCircles()[i], expectedCircles[i]) > 1e-4f || batch.getColors()[i] != expectedColors[i]) {
+				out << "interpolated circle " << i << " at alpha " << alpha << " is " << batch.getCircles()[i]
+					<< " instead of " << expectedCircles[i] << std::endl;
+				failures++;
+			}
+		}
+	}
+
+	// growing pads the arrays out to the new capacity for the upload, then
+	// shrinks them back without touching the circles that were added
+	CircleBatch growing;
+	int added = 0;
+	for (int count : { 37, 60, 300, 10 }) {
+		if (count < added) {
+			growing.clear();
+			added = 0;
+		}
+		for (; added < count; added++)
+			growing.add(glm::vec2(added * 3.5f, -added), 20 + added % 31, ofFloatColor(added % 2, 0.5f, added / 300.0f, 1));
+
+		const int capacityBefore = growing.getCapacity();
+		int expectedCapacity = capacityBefore;
+		if (count > capacityBefore)
+			for (expectedCapacity = std::max(64, capacityBefore); expectedCapacity < count; expectedCapacity *= 2) {}
+		int allocated = -1;
+		bool paddedIntact = true;
+		const bool grew = growing.growCapacity([&](const glm::vec3* circles, const ofFloatColor* colors, int capacity) {
+			allocated = capacity;
+			for (int i = 0; i < count; i++)
+				paddedIntact = paddedIntact && circles[i] == growing.getCircles()[i] && colors[i] == growing.getColors()[i];
+		});
+		if (grew != (expectedCapacity != capacityBefore) || (grew && allocated != expectedCapacity) || !paddedIntact
+			|| growing.getCapacity() != expectedCapacity) {
+			out << "circle batch of " << count << " grew from " << capacityBefore << " to " << growing.getCapacity()
+				<< " (allocated " << allocated << ") instead of " << expectedCapacity << std::endl;
+			failures++;
+		}
+		if (growing.size() != count || int(growing.getCircles().size()) != count || int(growing.getColors().size()) != count) {
+			out << "circle batch holds " << growing.size() << " circles instead of " << count << " after growing" << std::endl;
+			failures++;
+			continue;
+		}
+		for (int i = 0; i < count; i++) {
+			const auto& circle = growing.getCircles()[i];
+			const auto& color = growing.getColors()[i];
+			if (circle.x != i * 3.5f || circle.y != -i || circle.z != 20 + i % 31 ||
+				color.r != i % 2 || color.g != 0.5f || color.b != i / 300.0f || color.a != 1) {
+				out << "circle batch instance " << i << " of " << count << " changed while growing" << std::endl;
+				failures++;
+				break;
+			}
+		}
+	}
+	out << "circle batch: " << failures << " failures" << std::endl;
+	return failures == 0;
+}
+
+//--------------------------------------------------------------
+bool verifyQuadtreeMesh(const DepthDataset& dataset, std::ostream& out)
+{
+	DepthExtrusion extrusion;
+	extrusion.depthUnits = dataset.depthUnits;
+	extrusion.minRawDepth = minRawDepth;
+	extrusion.maxRawDepth = maxRawDepth;
+	extrusion.minMappedDepth = minMappedDepth;
+	extrusion.maxMappedDepth = maxMappedDepth;
+
+	QuadtreeMesh quadtree;
+	std::vector<ofIndexType> indices;
+	std::vector<uint64_t> edges;
+	int failures = 0;
+	int meshes = 0;
+	for (int stepSize : { 1, 3, 7 }) {
+		DepthSampling sampling;
+		sampling.width = dataset.width;
+		sampling.height = dataset.height;
+		sampling.stepSize = stepSize;
+		const int columns = sampling.getColumns();
+		const int rows = sampling.getRows();
+		std::vector<float> grid(columns * rows);
+		std::vector<glm::vec3> vertices(columns * rows);
+		std::vector<int> vertexAt(columns * rows);
+
+		for (size_t frame = 0; frame < dataset.frames.size(); frame++) {
+			// as TriangleMesh builds it: outliers marked, then filled
+			sampleDepthGrid(dataset.getView(frame), extrusion, sampling, true, grid.data());
+			fillDepthHoles(grid.data(), columns, rows, minMappedDepth, maxMappedDepth);
+
+			for (float tolerance : { 0.0f, adaptiveTolerance, 64.0f }) {
+				meshes++;
+				const int numVertices = quadtree.build(grid.data(), sampling, tolerance, vertices.data(), indices);
+				std::ostringstream where;
+				where << "quadtree mesh, step " << stepSize << ", frame " << frame << ", tolerance " << tolerance << ": ";
+
+				if (indices.size() % 3 != 0 || std::any_of(indices.begin(), indices.end(),
+					[&](ofIndexType index) { return int(index) >= numVertices; })) {
+					out << where.str() << "indices reference vertices past the " << numVertices << " returned" << std::endl;
+					failures++;
+					continue;
+				}
+
+				// the grid point of every vertex, each used once
+				std::fill(vertexAt.begin(), vertexAt.end(), -1);
+				std::vector<glm::ivec2> points(numVertices);
+				bool placed = true;
+				for (int i = 0; i < numVertices && placed; i++) {
+					const int column = int(vertices[i].x - sampling.border) / stepSize;
+					const int row = int(vertices[i].y - sampling.border) / stepSize;
+					placed = column >= 0 && column < columns && row >= 0 && row < rows && vertexAt[row * columns + column] < 0;
+					if (placed) {
+						vertexAt[row * columns + column] = i;
+						points[i] = glm::ivec2(column, row);
+					}
+				}
+				if (!placed) {
+					out << where.str() << "vertices off the grid or emitted twice" << std::endl;
+					failures++;
+					continue;
+				}
+
+				// the triangles cover the grid exactly once (in cells, twice the area)
+				int64_t doubledArea = 0;
+				bool degenerate = false;
+				edges.clear();
+				for (size_t i = 0; i < indices.size(); i += 3) {
+					const auto& a = points[indices[i]];
+					const auto& b = points[indices[i + 1]];
+					const auto& c = points[indices[i + 2]];
+					const int64_t cross = int64_t(b.x - a.x) * (c.y - a.y) - int64_t(b.y - a.y) * (c.x - a.x);
+					degenerate = degenerate || cross == 0;
+					doubledArea += std::abs(cross);
+					for (int corner = 0; corner < 3; corner++) {
+						const uint64_t from = indices[i + corner];
+						const uint64_t to = indices[i + (corner + 1) % 3];
+						edges.push_back(std::min(from, to) << 32 | std::max(from, to));
+					}
+				}
+				if (degenerate || doubledArea != 2 * int64_t(columns - 1) * (rows - 1)) {
+					out << where.str() << "triangles cover " << doubledArea / 2.0 << " cells of "
+						<< (columns - 1) * (rows - 1) << (degenerate ? ", some degenerate" : "") << std::endl;
+					failures++;
+				}
+
+				// every edge shared by two triangles, or one along the grid boundary,
+				// and no vertex strictly inside an edge (a T-junction)
+				std::sort(edges.begin(), edges.end());
+				int cracks = 0;
+				int tJunctions = 0;
+				for (size_t i = 0; i < edges.size();) {
+					size_t end = i + 1;
+					while (end < edges.size() && edges[end] == edges[i])
+						end++;
+					const auto& a = points[edges[i] >> 32];
+					const auto& b = points[edges[i] & 0xffffffff];
+					const bool boundary = (a.x == b.x && (a.x == 0 || a.x == columns - 1))
+						|| (a.y == b.y && (a.y == 0 || a.y == rows - 1));
+					if (end - i != (boundary ? 1 : 2))
+						cracks++;
+					const int steps = std::gcd(std::abs(b.x - a.x), std::abs(b.y - a.y));
+					for (int k = 1; k < steps; k++) {
+						const int column = a.x + (b.x - a.x) / steps * k;
+						const int row = a.y + (b.y - a.y) / steps * k;
+						if (vertexAt[row * columns + column] >= 0)
+							tJunctions++;
+					}
+					i = end;
+				}
+				if (cracks > 0 || tJunctions > 0) {
+					out << where.str() << cracks << " edges not shared by exactly two triangles, "
+						<< tJunctions << " T-junctions" << std::endl;
+					failures++;
+				}
+			}
+		}
+	}
+	out << "quadtree mesh: " << dataset.name << ", " << meshes << " meshes, " << failures << " failures" << std::endl;
+	return failures == 0;
+}
+
+void printResults(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+	std::string dataset;
+	for (const auto& result : results) {
+		if (result.dataset != dataset) {
+			dataset = result.dataset;
+			out << std::endl << dataset << " (" << result.width << "x" << result.height << ")" << std::endl;
+			out << std::setw(32) << std::left << "kernel" << std::right
+				<< std::setw(6) << "step"
+				<< std::setw(8) << "threads"
+				<< std::setw(14) << "ns/frame"
+				<< std::setw(16) << "vertices/s"
+				<< std::setw(12) << "allocs/frame" << std::endl;
+		}
+		out << std::setw(32) << std::left << result.kernel << std::right
+			<< std::setw(6) << result.stepSize
+			<< std::setw(8) << result.threads
+			<< std::setw(14) << std::fixed << std::setprecision(0) << result.nsPerFrame
+			<< std::setw(16) << std::scientific << std::setprecision(3) << result.getVerticesPerSecond()
+			<< std::setw(12) << std::fixed << std::setprecision(2) << result.allocationsPerFrame
+			<< (result.matchesSerial ? "" : "  MISMATCH") << std::endl;
+	}
+}
+
+bool writeJsonResults(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "{" << std::endl << "  \"results\": [" << std::endl;
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& result = results[i];
+		out << "    {\"dataset\": " << jsonString(result.dataset)
+			<< ", \"width\": " << result.width
+			<< ", \"height\": " << result.height
+			<< ", \"kernel\": " << jsonString(result.kernel)
+			<< ", \"stepSize\": " << result.stepSize
+			<< ", \"threads\": " << result.threads
+			<< ", \"iterations\": " << result.iterations
+			<< std::fixed << std::setprecision(1)
+			<< ", \"nsPerFrame\": " << result.nsPerFrame
+			<< ", \"verticesPerFrame\": " << result.verticesPerFrame
+			<< ", \"verticesPerSecond\": " << result.getVerticesPerSecond()
+			<< std::setprecision(3)
+			<< ", \"allocationsPerFrame\": " << result.allocationsPerFrame
+			<< ", \"matchesSerial\": " << (result.matchesSerial ? "true" : "false")
+			<< "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+	}
+	out << "  ]" << std::endl << "}" << std::endl;
+	return bool(out);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "depthView.h"
+
+// A handful of depth frames copied out of a DepthSource, so every kernel of a
+// run sees exactly the same input and nothing waits on the source while timing.
+struct DepthDataset
+{
+	std::string name;
+	int width = 0;
+	int height = 0;
+	float depthUnits = 0.001f;
+	std::vector<std::vector<uint16_t>> frames; // width * height samples each, no padding
+	rs2::frame firstFrame; // for the kernels that go through the rs2::depth_frame API
+
+	DepthView getView(size_t frameIndex) const;
+};
+
+// Starts the source described like the apps' --source=, copies frameCount
+// frames (after skipping warmupFrames) and stops it again.
+DepthDataset captureDataset(const std::string& description, int frameCount, int warmupFrames);
+
+struct BenchmarkSettings
+{
+	int minStepSize = 1;
+	int maxStepSize = 16;
+	double minSecondsPerKernel = 0.05; // iterations double until a kernel has run at least this long
+	bool baselines = false;            // also time the code paths the kernels replaced
+	int threads = 0;                   // worker pool size for the *_parallel kernels, 0 = all cores, 1 = skip them
+};
+
+struct BenchmarkResult
+{
+	std::string dataset;
+	int width = 0;
+	int height = 0;
+	std::string kernel;
+	int stepSize = 0; // 0 for kernels that don't depend on it
+	int threads = 1;
+	long iterations = 0;
+	double nsPerFrame = 0;
+	double verticesPerFrame = 0;
+	double allocationsPerFrame = 0;
+	// *_parallel and *_incremental kernels: output identical to the serial full
+	// build; box2d_roi_sat(_median): centre window mean as box2d_roi's; recording_decode:
+	// every frame decoded back bit for bit
+	bool matchesSerial = true;
+
+	double getVerticesPerSecond() const { return nsPerFrame > 0 ? verticesPerFrame * 1e9 / nsPerFrame : 0; }
+};
+
+std::vector<BenchmarkResult> runBenchmarks(const DepthDataset& dataset, const BenchmarkSettings& settings);
+
+// Checks that every SIMD path of extrudeDepthRow() matches the scalar path bit
+// for bit, and the scalar path DepthLut (i.e. ofMap()), over all 65536 Z16
+// values for a set of depth ranges. Failures are written to out.
+bool verifyDepthExtrusion(std::ostream& out);
+
+// Checks that addInterpolatedCircles() skips parked slots, blends only bodies
+// that weren't respawned and colours hit ones, and that CircleBatch keeps the
+// circles added to it while growing its capacity. Needs no GL context.
+// Failures are written to out.
+bool verifyCircleBatch(std::ostream& out);
+
+// Checks that QuadtreeMesh::build() meshes the dataset's frames, at a few
+// stepSizes and tolerances, without cracks or T-junctions: its indices stay
+// below the returned vertex count, the triangles cover the grid exactly once,
+// every edge is shared by two triangles unless it lies on the grid boundary,
+// and no vertex lies strictly inside an edge. Failures are written to out.
+bool verifyQuadtreeMesh(const DepthDataset& dataset, std::ostream& out);
+
+void printResults(std::ostream& out, const std::vector<BenchmarkResult>& results);
+bool writeJsonResults(const std::string& path, const std::vector<BenchmarkResult>& results);
@@ -0,0 +1,134 @@
+#include "ofMain.h"
+#include "benchmarkSuite.h"
+#include <iostream>
+
+// Windowless benchmark for the per-frame depth-to-geometry kernels of the apps:
+//   pointcloud              PointCloud vertex build (filterNoise on)
+//   topography              AliensTopography scanline build
+//   topography_smoothing    AliensTopography outlier smoothing
+//   trianglemesh_grid       TriangleMesh depth grid sampling and vertex build
+//   trianglemesh_smoothing  TriangleMesh fillDepthHoles()
+//   trianglemesh_indices    TriangleMesh index generation on a shape change
+//   trianglemesh_adaptive   TriangleMesh restricted quadtree mesh (tolerance 4)
+//   trianglemesh_labels     TriangleMesh labelPoints text of the vertices that moved
+//   box2d_roi               ofxBox2d calculateDepth() ROI average
+//   box2d_roi_sat           DepthRoiStats mean tables (as calculateDepth() builds them)
+//                           and 257 zone queries, the centre one checked against box2d_roi
+//   box2d_roi_sat_median    the same with the 8 median histogram tables
+//   box2d_contours          DepthContours silhouette outlines (default settings)
+//   recording_encode        depth recording row coding, keyframe then deltas
+//   recording_decode        and decoding it back, checked against the frames
+//   extrude_lut             Z16 to extruded z through the DepthLut table
+//   extrude_<path>          extrudeDepthRow() on each supported SIMD path
+//   pool_<mode>             poolDepthBlocks() min, median and mean block pooling
+//                           checked against a plain per-block reduction
+//   *_parallel              pointcloud, topography (build and smoothing) and
+//                           trianglemesh_grid split into row bands on a WorkerPool,
+//                           checked against the serial output
+//   dirty_tiles_static      DirtyTiles change detection on a frame that didn't change
+//   *_incremental           topography and trianglemesh rebuilding only the tiles
+//                           that changed since the previous frame, checked against
+//                           a full build of the last frame
+// for every stepSize from 1 to 16, reporting ns/frame, vertices/s and heap
+// allocations per frame.
+//
+// Options:
+//   --source=<description>  dataset to run on, repeatable; same descriptions as the
+//                           apps' --source= (default: synthetic sphere at 424x240,
+//                           640x480, 848x480 and 1280x720)
+//   --frames=<n>            frames captured per dataset (default 4)
+//   --steps=<min>-<max>     stepSize range (default 1-16)
+//   --min-time=<ms>         minimum run time per kernel (default 50)
+//   --baseline              also time get_distance() and per-row smoothing
+//   --threads=<n>           largest worker pool for the *_parallel kernels, which also
+//                           run on 2, 4, 8 .. threads (default: all cores, 1 = skip)
+//   --json=<path>           write the results as JSON for regression tracking
+//   --verify                only check that every SIMD path of extrudeDepthRow()
+//                           matches the scalar one bit for bit, that the Box2D circles
+//                           are interpolated between ticks as drawn and that CircleBatch
+//                           keeps them while growing, and that the adaptive mesh of
+//                           every dataset has no cracks or T-junctions; exit status 1 if not
+
+//========================================================================
+int main(int argc, char* argv[]) {
+	std::vector<std::string> sources;
+	std::string jsonPath;
+	int frameCount = 4;
+	BenchmarkSettings settings;
+	bool verify = false;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg.compare(0, 9, "--source=") == 0)
+			sources.push_back(arg.substr(9));
+		else if (arg.compare(0, 9, "--frames=") == 0)
+			frameCount = std::max(1, std::atoi(arg.c_str() + 9));
+		else if (arg.compare(0, 8, "--steps=") == 0)
+			std::sscanf(arg.c_str() + 8, "%d-%d", &settings.minStepSize, &settings.maxStepSize);
+		else if (arg.compare(0, 11, "--min-time=") == 0)
+			settings.minSecondsPerKernel = std::atof(arg.c_str() + 11) / 1000.0;
+		else if (arg.compare(0, 10, "--threads=") == 0)
+			settings.threads = std::atoi(arg.c_str() + 10);
+		else if (arg == "--baseline")
+			settings.baselines = true;
+		else if (arg.compare(0, 7, "--json=") == 0)
+			jsonPath = arg.substr(7);
+		else if (arg == "--verify")
+			verify = true;
+		else {
+			std::cerr << "unknown option " << arg << std::endl;
+			return 1;
+		}
+	}
+	settings.minStepSize = std::max(1, settings.minStepSize);
+
+	if (sources.empty()) {
+		// fps 0 so capturing doesn't wait on a frame clock
+		sources = {
+			"synthetic:sphere:424x240@0",
+			"synthetic:sphere:640x480@0",
+			"synthetic:sphere:848x480@0",
+			"synthetic:sphere:1280x720@0"
+		};
+	}
+
+	if (verify) {
+		bool matches = verifyDepthExtrusion(std::cout);
+		matches = verifyCircleBatch(std::cout) && matches;
+		for (const auto& source : sources) {
+			const auto dataset = captureDataset(source, frameCount, 30);
+			if (dataset.frames.empty()) {
+				std::cerr << "no frames from " << source << std::endl;
+				return 1;
+			}
+			matches = verifyQuadtreeMesh(dataset, std::cout) && matches;
+		}
+		return matches ? 0 : 1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	for (const auto& source : sources) {
+		// skip a few frames so a camera's auto exposure settles
+		const auto dataset = captureDataset(source, frameCount, 30);
+		if (dataset.frames.empty()) {
+			std::cerr << "no frames from " << source << std::endl;
+			return 1;
+		}
+		const auto datasetResults = runBenchmarks(dataset, settings);
+		printResults(std::cout, datasetResults);
+		results.insert(results.end(), datasetResults.begin(), datasetResults.end());
+	}
+
+	const bool mismatch = std::any_of(results.begin(), results.end(), [](const BenchmarkResult& result) { return !result.matchesSerial; });
+	if (mismatch)
+		std::cerr << "parallel, incremental, ROI table or decoded recording output differs from the reference kernels" << std::endl;
+
+	if (!jsonPath.empty()) {
+		if (!writeJsonResults(jsonPath, results)) {
+			std::cerr << "can't write " << jsonPath << std::endl;
+			return 1;
+		}
+		std::cout << std::endl << "results written to " << jsonPath << std::endl;
+	}
+	return mismatch ? 1 : 0;
+}
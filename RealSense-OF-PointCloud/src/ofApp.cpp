@@ -1,4 +1,7 @@
 #include "ofApp.h"
+#include "depthPooling.h"
+#include "depthView.h"
+#include "meshKernels.h"
 #include <string>
 #include <iostream>
 
@@ -12,10 +15,15 @@ namespace {
 	bool filterNoise = false;
 	bool connectLines = false;
 	auto connectDistance = 50;
+	int maxEdgesPerVertex = 6;
 	auto minRawDepth = 0.1;
 	auto maxRawDepth = 5.0;
 	auto minMappedDepth = 1;
 	auto maxMappedDepth = 1000;
+	bool parallelBuild = true;
+	DepthPooling depthPooling = DepthPooling::Point;
+	bool incrementalUpdates = false;
+	int changeThreshold = 10; // mm
 	int stepSize = 4;
 
 	typedef std::pair <std::string, ofPrimitiveMode> primativePair;
@@ -34,90 +42,141 @@ namespace {
 
 //--------------------------------------------------------------
 void ofApp::setup() {
-	rs2_pipe.start();
+	workerPool = std::make_unique<WorkerPool>(options.threads);
+	depthCapture.setProfiler(&profiler);
+	depthCapture.start(createDepthSource(options.depthSource));
+	if (!options.record.empty())
+		depthRecorder.start(options.record);
+	if (options.headless)
+		return; // no GL context to set up, only the geometry pipeline runs
 	ofSetVerticalSync(true);
 
 	ofEnableDepthTest();
-	glEnable(GL_POINT_SMOOTH); // use circular points instead of square points
-	glPointSize(3); // make the points bigger
-
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
-	if (connectLines)
+	// Pick up the newest depth frame from the capture thread.
+	// If none arrived since the last update keep drawing the current mesh.
+	rs2::frame frame = depthCapture.getLatestFrame();
+	if (!frame)
+		return;
+	rs2::depth_frame depth = frame;
+	depthRecorder.add(depth);
+
+	processedFrames++;
+	if (options.frames > 0 && processedFrames >= options.frames)
+		ofExit();
+
+	// Raw Z16 samples are mapped to extruded depth a row at a time by a SIMD kernel.
+	depthExtrusion.depthUnits = depth.get_units();
+	depthExtrusion.minRawDepth = minRawDepth;
+	depthExtrusion.maxRawDepth = maxRawDepth;
+	depthExtrusion.minMappedDepth = minMappedDepth;
+	depthExtrusion.maxMappedDepth = maxMappedDepth;
+	depthExtrusion.clamp = true;
+	depthExtrusion.exclusiveRange = true; // filterNoise drops the clamped floor/ceiling points
+	const auto depthView = DepthView::fromFrame(depth);
+
+	DepthSampling sampling;
+	// at most depthFrameWidth x depthFrameHeight; smaller sources are sampled whole
+	sampling.width = std::min(depthView.width, depthFrameWidth);
+	sampling.height = std::min(depthView.height, depthFrameHeight);
+	sampling.stepSize = stepSize;
+
+	// Vertex storage is only reallocated when stepSize changes the grid shape.
+	// Every other frame positions are overwritten in place and only they are re-uploaded.
+	if (mesh.allocate(sampling.getColumns(), sampling.getRows()))
+		mesh.setColor(ofColor::green);
+
+	// Rows are independent, so with parallelBuild they are built in bands on the worker pool.
+	WorkerPool* pool = parallelBuild ? workerPool.get() : nullptr;
+
+	// With depthPooling every stepSize x stepSize block is first reduced to one value (the
+	// min, median or mean of its valid pixels), and everything below reads those instead
+	// of one pixel per block, so dropouts and noise don't alias into the mesh.
+	DepthView sampleView = depthView;
+	if (depthPooling != DepthPooling::Point)
 	{
-		mesh.setMode(primativeModeIterator->second);
-		mesh.enableIndices();
-	}
-	else {
-		mesh.setMode(OF_PRIMITIVE_POINTS);
+		ScopedStageTimer timer(profiler, StageProfiler::Downsampling);
+		pooledDepth.resize(sampling.getColumns() * sampling.getRows());
+		poolDepthBlocks(depthView, sampling, depthPooling, pooledDepth.data(), pool);
+		sampleView = DepthView::fromSamples(pooledDepth.data(), sampling.getColumns(), sampling.getRows());
+		sampling.preSampled = true;
 	}
 
-	mesh.clear();
-
-	// Block program until frames arrive
-	rs2::frameset frames = rs2_pipe.wait_for_frames();
-	// Try to get a frame of a depth image
-	rs2::depth_frame depth = frames.get_depth_frame();
-
-	// loop through the image in the x and y axes
-	for (int y = 0; y < depthFrameHeight; y += stepSize) {
-		for (int x = 0; x < depthFrameWidth; x += stepSize) {
-			const ofColor pointColor = ofColor::green;
-			auto depthValue = depth.get_distance(x, y);
-
-			// map depthValue to extrude it a bit
-			auto extrudedDepthValue = ofMap(depthValue, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, true);
-			mesh.addColor(pointColor);
-			glm::vec3 pos(x, y, extrudedDepthValue);
-			// ignore floor/ceiling points
-			if (filterNoise && (extrudedDepthValue > minMappedDepth && extrudedDepthValue < maxMappedDepth)) {
-				mesh.addVertex(pos);
-			}
-			else if (!filterNoise)
-			{
-				mesh.addVertex(pos);
-			}
+	auto& vertices = mesh.getVertices();
+	int numVertices;
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::DepthConversion);
+		// With incrementalUpdates only the tiles whose depth moved by more than changeThreshold
+		// are rebuilt and re-uploaded, and a frame in which nothing moved is skipped.
+		// filterNoise packs the points together, so there any change still rebuilds the whole cloud.
+		if (incrementalUpdates && dirtyTiles.update(sampleView, sampling, depth.get_units(), changeThreshold / 1000.0f, pool) == 0)
+			return;
+
+		if (incrementalUpdates && !filterNoise) {
+			buildScanlines(sampleView, depthExtrusion, sampling, false, vertices.data(), dirtyTiles, pool);
+			mesh.updateVertices(dirtyTiles);
+			numVertices = mesh.getNumVertices();
+		}
+		else {
+			numVertices = buildPointCloud(sampleView, depthExtrusion, sampling, filterNoise, vertices.data(), pool);
+			mesh.updateVertices(numVertices);
 		}
 	}
 
-
 	// https://openframeworks.cc/ofBook/chapters/generativemesh.html
+	// Points are bucketed into connectDistance sized cells so each one is only
+	// compared against its neighbouring cells instead of every other point.
 	if (connectLines)
 	{
-		int numVerts = mesh.getNumVertices();
-		for (int a = 0; a < numVerts; ++a) {
-			ofVec3f verta = mesh.getVertex(a);
-			for (int b = a + 1; b < numVerts; ++b) {
-				ofVec3f vertb = mesh.getVertex(b);
-				float distance = verta.distance(vertb);
-				if (distance <= connectDistance) {
-					// In OF_PRIMITIVE_LINES, every pair of vertices or indices will be
-					// connected to form a line
-					mesh.addIndex(a);
-					mesh.addIndex(b);
-				}
-			}
-		}
+		ScopedStageTimer timer(profiler, StageProfiler::Indices);
+		auto& indices = mesh.getIndices();
+		indices.clear();
+		spatialHash.build(vertices.data(), numVertices, connectDistance);
+		spatialHash.findPairs(connectDistance, maxEdgesPerVertex, indices);
+		mesh.updateIndices();
 	}
+
+	// Hand the finished cloud to the export thread, if a snapshot or stream wants it
+	geometryExporter.submit(vertices, numVertices, mesh.getIndices(), mesh.getIndicesVersion(),
+		connectLines ? primativeModeIterator->second : OF_PRIMITIVE_POINTS);
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-	ofBackgroundGradient(ofColor::gray, ofColor::black, OF_GRADIENT_CIRCULAR);
-
-	// even points can overlap with each other, let's avoid that
-	cam.begin();
-	ofScale(2, -2, 2); // flip the y axis and zoom in a bit
-	ofRotateYDeg(90);
-	ofTranslate(-appWidth / 2, -appHeight / 2);
-	mesh.draw();
-	//mesh.drawFaces();
-	//mesh.drawWireframe();
-	cam.end();
+	if (options.headless)
+		return;
+
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Upload);
+		mesh.upload();
+	}
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Draw);
+		ofBackgroundGradient(ofColor::gray, ofColor::black, OF_GRADIENT_CIRCULAR);
+
+		// even points can overlap with each other, let's avoid that
+		cam.begin();
+		ofScale(2, -2, 2); // flip the y axis and zoom in a bit
+		ofRotateYDeg(90);
+		ofTranslate(-appWidth / 2, -appHeight / 2);
+		// the programmable renderer has no GL_POINT_SMOOTH, a shader draws the points round
+		const bool points = !connectLines || primativeModeIterator->second == OF_PRIMITIVE_POINTS;
+		if (points)
+			roundPoints.begin(mesh.hasColor());
+		if (connectLines)
+			mesh.drawElements(primativeModeIterator->second);
+		else
+			mesh.draw(OF_PRIMITIVE_POINTS);
+		if (points)
+			roundPoints.end();
+		cam.end();
+	}
 
 	// Draw Text
+	ScopedStageTimer timer(profiler, StageProfiler::Hud);
 	stringstream ss;
 	ss << "Point Density (m, n): " << stepSize << std::endl;
 	ss << "minRawDepth (p,o): " << minRawDepth << std::endl;
@@ -125,17 +184,90 @@ void ofApp::draw(){
 	ss << "filterNoise (f): " << (filterNoise ? "true" : "false") << std::endl;
 	ss << "connectLines (c): " << (connectLines ? "true" : "false") << std::endl;
 	ss << "connectDistance (r,t): " << connectDistance << std::endl;
+	ss << "maxEdgesPerVertex (w,e): " << maxEdgesPerVertex << std::endl;
 	ss << "primativeMode (x): " << primativeModeIterator->first << std::endl;
+	ss << "parallelBuild (j): " << (parallelBuild ? workerPool->getNumThreads() : 1) << " threads" << std::endl;
+	ss << "depthPooling (b): " << getDepthPoolingName(depthPooling) << std::endl;
+	ss << "extrusion: " << getSimdPathName(getSupportedSimdPath()) << std::endl;
+	ss << "incrementalUpdates (i): " << (incrementalUpdates ? "true" : "false") << std::endl;
+	ss << "changeThreshold (g,h): " << changeThreshold << " mm" << std::endl;
+	ss << "tiles touched: " << ofToString(dirtyTiles.getDirtyFraction() * 100, 1) << "% (avg "
+		<< ofToString(dirtyTiles.getCounters().getDirtyFraction() * 100, 1) << "%), frames skipped: "
+		<< dirtyTiles.getCounters().skippedFrames << "/" << dirtyTiles.getCounters().frames << std::endl;
+	ss << "capture dropped/duplicate: " << depthCapture.getDroppedFrames() << "/" << depthCapture.getDuplicateFrames() << std::endl;
+	ss << "recording (R): " << depthRecorder.getSummary() << std::endl;
+	ss << "export (S, E): " << geometryExporter.getSummary() << std::endl;
 	ofDrawBitmapString(ss.str().c_str(), 20, 20);
+	profiler.draw(400, 20);
 
 }
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+	depthCapture.stop();
+	depthRecorder.stop();
+	geometryExporter.stop();
+	ofLogNotice() << processedFrames << " frames from " << depthCapture.getSourceDescription()
+		<< ", " << depthCapture.getDroppedFrames() << " dropped";
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+	// Any setting can change the mesh, so rebuild every tile on the next frame
+	dirtyTiles.invalidate();
+
+	// Save the geometry as PLY
+	if (key == 'S')
+		geometryExporter.requestSnapshot("mesh_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".ply");
+
+	// Toggle streaming the geometry of every frame
+	if (key == 'E') {
+		if (geometryExporter.isStreaming())
+			geometryExporter.stopStream();
+		else
+			geometryExporter.startStream("mesh_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".pstream");
+	}
+
+	// Toggle recording the depth frames
+	if (key == 'R') {
+		if (depthRecorder.isRecording())
+			depthRecorder.stop();
+		else
+			depthRecorder.start(ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".rsdepth");
+	}
+
 	// Toggle Filtering
 	if (key == 'f')
 		filterNoise = !filterNoise;
 
+	// Toggle the parallel mesh build
+	if (key == 'j')
+		parallelBuild = !parallelBuild;
+
+	// Cycle the block pooling mode
+	if (key == 'b')
+		depthPooling = DepthPooling((int(depthPooling) + 1) % 4);
+
+	// Toggle incremental mesh updates
+	if (key == 'i') {
+		incrementalUpdates = !incrementalUpdates;
+		dirtyTiles.resetCounters();
+	}
+
+	// Increase Decrease changeThreshold
+	if (key == 'h') changeThreshold += 1;
+	if (key == 'g') {
+		if (changeThreshold > 0)
+			changeThreshold -= 1;
+	};
+
+	// Save the stage timings
+	if (key == 'v') {
+		const auto path = "stages_" + ofGetTimestampString() + ".csv";
+		if (profiler.saveCsv(path))
+			ofLogNotice() << "stage timings saved to " << path;
+	}
+
 	// Cycle Primative Mode 
 	if (key == 'x') {
 		// MK NOTE: end() actually returns an iterator referring to the "past-the-end" element.
@@ -202,6 +334,13 @@ void ofApp::keyPressed(int key){
 			connectDistance -= 5;
 	};
 
+	// Increase Decrease maxEdgesPerVertex
+	if (key == 'e') maxEdgesPerVertex += 1;
+	if (key == 'w') {
+		if (maxEdgesPerVertex > 1)
+			maxEdgesPerVertex -= 1;
+	};
+
 
 }
 
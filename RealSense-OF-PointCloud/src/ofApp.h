@@ -2,6 +2,17 @@
 
 #include <librealsense2/rs.hpp>
 #include "ofMain.h"
+#include "appOptions.h"
+#include "depthCapture.h"
+#include "depthExtrusion.h"
+#include "depthRecorder.h"
+#include "dirtyTiles.h"
+#include "geometryExporter.h"
+#include "gridMesh.h"
+#include "roundPoints.h"
+#include "spatialHashGrid.h"
+#include "stageProfiler.h"
+#include "workerPool.h"
 
 class ofApp : public ofBaseApp{
 
@@ -9,6 +20,7 @@ class ofApp : public ofBaseApp{
 		void setup();
 		void update();
 		void draw();
+		void exit();
 
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -22,7 +34,15 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 
-		rs2::pipeline rs2_pipe;
+		AppOptions options;
+		DepthCapture depthCapture;
+		DepthRecorder depthRecorder;
+		GeometryExporter geometryExporter;
+		StageProfiler profiler;
+		std::unique_ptr<WorkerPool> workerPool;
+		int processedFrames = 0;
+		DepthExtrusion depthExtrusion;
+		std::vector<uint16_t> pooledDepth;
 
 		static const int appWidth;
 		static const int appHeight;
@@ -31,5 +51,8 @@ class ofApp : public ofBaseApp{
 		static int squareLength;
 
 		ofEasyCam cam;
-		ofMesh mesh;
+		GridMesh mesh;
+		RoundPoints roundPoints{ 3 }; // circular points, 3 pixels wide
+		DirtyTiles dirtyTiles;
+		SpatialHashGrid spatialHash;
 };
@@ -1,10 +1,23 @@
 #include "ofMain.h"
+#include "ofAppNoWindow.h"
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
 	const auto appWidth = 848 * 2;
 	const auto appHeight = 480 * 2;
-	ofSetupOpenGL(appWidth, appHeight, OF_WINDOW);
-	ofRunApp(new ofApp());
+	const auto options = AppOptions::parse(argc, argv);
+	if (options.headless)
+		ofSetupOpenGL(std::make_shared<ofAppNoWindow>(), appWidth, appHeight, OF_WINDOW);
+	else {
+		// GL 3.1 or later, for the primitive restart in GridMesh::drawElements()
+		ofGLWindowSettings settings;
+		settings.setGLVersion(3, 3);
+		settings.setSize(appWidth, appHeight);
+		ofCreateWindow(settings);
+	}
+
+	auto app = new ofApp();
+	app->options = options;
+	ofRunApp(app);
 }
@@ -1,4 +1,8 @@
 #include "ofApp.h"
+#include "depthPooling.h"
+#include "depthView.h"
+#include "holeFilling.h"
+#include "meshKernels.h"
 #include <string>
 #include <iostream>
 
@@ -10,6 +14,7 @@ const int ofApp::appHeight = depthFrameHeight * 2;
 namespace {
 	bool enableNoiseSmoothing = true;
 	bool labelPoints = false;
+	auto labelDistance = 1000; // from the camera, labels further away are culled
 	auto minRawDepth = 0.1;
 	auto maxRawDepth = 2.0;
 	auto minMappedDepth = 1;
@@ -17,6 +22,12 @@ namespace {
 	auto spotZ = 100;
 	auto spotX = 100;
 	auto spotY = -175;
+	bool parallelBuild = true;
+	DepthPooling depthPooling = DepthPooling::Point;
+	bool incrementalUpdates = false;
+	int changeThreshold = 10; // mm
+	bool adaptiveMesh = false;
+	int adaptiveTolerance = 4; // in extruded depth units
 	int stepSize = 7;
 
 	typedef std::pair <std::string, ofPrimitiveMode> primativePair;
@@ -35,171 +46,313 @@ namespace {
 
 //--------------------------------------------------------------
 void ofApp::setup() {
-	rs2_pipe.start();
+	workerPool = std::make_unique<WorkerPool>(options.threads);
+	depthCapture.setProfiler(&profiler);
+	depthCapture.start(createDepthSource(options.depthSource));
+	if (!options.record.empty())
+		depthRecorder.start(options.record);
+	if (options.headless)
+		return; // no GL context to set up, only the geometry pipeline runs
 	ofSetVerticalSync(true);
 
 	spot.setup();
 
 	meshMaterial.setDiffuseColor(ofColor::orange);
 	meshMaterial.setShininess(0.01);
-
-	glEnable(GL_POINT_SMOOTH); // use circular points instead of square points
-	glPointSize(3); // make the points bigger
-
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
-
-	// Block program until frames arrive
-	rs2::frameset frames = rs2_pipe.wait_for_frames();
-	// Try to get a frame of a depth image
-	rs2::depth_frame depth = frames.get_depth_frame();
-
-	int vertCounter = 0;
-	mesh.clear();
-	mesh.setMode(primativeModeIterator->second);
-	mesh.enableIndices();
-
 	spot.setPosition(spotX,spotY,spotZ);
 
-	// loop through the image in the x and y axes
-	for (int y = 0; y < depthFrameHeight; y += stepSize) {
-
-
-		for (int x = 0; x < depthFrameWidth; x += stepSize) {
+	// Pick up the newest depth frame from the capture thread.
+	// If none arrived since the last update keep drawing the current mesh.
+	rs2::frame frame = depthCapture.getLatestFrame();
+	if (!frame)
+		return;
+	rs2::depth_frame depth = frame;
+	depthRecorder.add(depth);
+
+	processedFrames++;
+	if (options.frames > 0 && processedFrames >= options.frames)
+		ofExit();
+
+	// Raw Z16 samples are mapped to extruded depth a row at a time by a SIMD kernel.
+	depthExtrusion.depthUnits = depth.get_units();
+	depthExtrusion.minRawDepth = minRawDepth;
+	depthExtrusion.maxRawDepth = maxRawDepth;
+	depthExtrusion.minMappedDepth = minMappedDepth;
+	depthExtrusion.maxMappedDepth = maxMappedDepth;
+	const auto depthView = DepthView::fromFrame(depth);
+
+	// Vertex storage is only rebuilt when stepSize changes the grid shape, and the
+	// index buffer only when the shape or the primitive mode (y) changes.
+	// Every other frame positions are overwritten in place and only they are re-uploaded.
+	DepthSampling sampling;
+	// at most depthFrameWidth x depthFrameHeight; smaller sources are sampled whole
+	sampling.width = std::min(depthView.width, depthFrameWidth);
+	sampling.height = std::min(depthView.height, depthFrameHeight);
+	sampling.stepSize = stepSize;
+
+	const int columns = sampling.getColumns();
+	const int rows = sampling.getRows();
+	mesh.allocate(columns, rows);
+	const bool gridIndicesChanged = gridIndices.update(columns, rows, primativeModeIterator->second);
+	if (!adaptiveMesh && (gridIndicesChanged || meshHasQuadtreeIndices))
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Indices);
+		mesh.getIndices() = gridIndices.getIndices();
+		mesh.updateIndices();
+		meshHasQuadtreeIndices = false;
+	}
 
-			// map depthValue to extrude it a bit
-			auto depthValue = depth.get_distance(x, y);
-			auto extrudedDepthValue = ofMap(depthValue, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, false);
+	// Sample the frame into a compact depth grid first so outliers can be filled
+	// in one pass over the whole grid. Rows are independent, so with parallelBuild
+	// sampling and vertex building run in bands on the worker pool.
+	WorkerPool* pool = parallelBuild ? workerPool.get() : nullptr;
 
-			// arbitrarilly set outlier point to `minMappedDepth - 1` as a signal it needs to be interpolated.
-			if (enableNoiseSmoothing && (extrudedDepthValue < minMappedDepth || extrudedDepthValue > maxMappedDepth))
-			{
-				extrudedDepthValue = minMappedDepth - 1; // -1 to bypass any weird float comparision.
-			}
+	// With depthPooling every stepSize x stepSize block is first reduced to one value (the
+	// min, median or mean of its valid pixels), and everything below reads those instead
+	// of one pixel per block, so dropouts and noise don't alias into the mesh.
+	DepthView sampleView = depthView;
+	if (depthPooling != DepthPooling::Point)
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Downsampling);
+		pooledDepth.resize(columns * rows);
+		poolDepthBlocks(depthView, sampling, depthPooling, pooledDepth.data(), pool);
+		sampleView = DepthView::fromSamples(pooledDepth.data(), columns, rows);
+		sampling.preSampled = true;
+	}
 
-			glm::vec3 pos(x, y, extrudedDepthValue);
-			mesh.addVertex(pos);
-			mesh.addIndex(vertCounter);
-			vertCounter++;
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::DepthConversion);
+		depthGrid.resize(columns * rows);
+		if (incrementalUpdates)
+		{
+			// Only the tiles whose depth moved by more than changeThreshold are resampled, into a
+			// grid that keeps the other tiles' samples, and a frame in which nothing moved is skipped.
+			if (dirtyTiles.update(sampleView, sampling, depth.get_units(), changeThreshold / 1000.0f, pool) == 0)
+				return;
+			sampledGrid.resize(columns * rows);
+			sampleDepthGrid(sampleView, depthExtrusion, sampling, enableNoiseSmoothing, sampledGrid.data(), dirtyTiles, pool);
+			depthGrid = sampledGrid;
 		}
+		else
+			sampleDepthGrid(sampleView, depthExtrusion, sampling, enableNoiseSmoothing, depthGrid.data(), pool);
 
-		// Iterate through the completed mesh and interpolate if needed.
+		// Interpolate outliers from their nearest valid neighbours along their row and column.
+		// Outliers with no valid neighbour at all end up at maxMappedDepth.
 		if (enableNoiseSmoothing)
 		{
-			for (int i = 0; i < mesh.getNumVertices(); i++)
-			{
-				auto targetVert = mesh.getVertex(i);
-				bool targetVertDirty = false;
-				bool hasPrevVert = (i != 0 ? true : false);
-				bool hasNextVert = (i != (mesh.getNumVertices() - 1) ? true : false);
-
-				// lerp interior nodes that are outliers
-				if (targetVert.z < minMappedDepth && (hasPrevVert && hasNextVert)) {
-					targetVertDirty = true;
-					auto prevVertZ = mesh.getVertex(i - 1).z;
-					auto nextVertZ = mesh.getVertex(i + 1).z;
-					targetVert.z = ofLerp(prevVertZ, nextVertZ, 0.5);
-				}
-				
-				// set exterior nodes that our outliers to maxMappedDepth
-				if (hasPrevVert != hasNextVert) {
-					targetVertDirty = true;
-					targetVert.z = maxMappedDepth;
-				}
-
-				if (targetVertDirty)
-					mesh.setVertex(i, targetVert);
-			}
+			ScopedStageTimer smoothingTimer(profiler, StageProfiler::Smoothing);
+			fillDepthHoles(depthGrid.data(), columns, rows, minMappedDepth, maxMappedDepth);
 		}
 
-	}
-
-	// MK TODO: This needs to take into account the step size
-	// Add indexes for triangle strip primative
-	for (int y = 0; y < (depthFrameHeight / stepSize); y++) {
-		for (int x = 0; x < (depthFrameWidth / stepSize); x++) {
-			mesh.addIndex(x + y * (depthFrameWidth / stepSize));               // 0
-			mesh.addIndex((x + 1) + y * (depthFrameWidth / stepSize));           // 1
-			mesh.addIndex(x + (y + 1) * (depthFrameWidth / stepSize));           // 10
-
-			mesh.addIndex((x + 1) + y * (depthFrameWidth / stepSize));           // 1
-			mesh.addIndex((x + 1) + (y + 1) * (depthFrameWidth / stepSize));       // 11
-			mesh.addIndex(x + (y + 1) * (depthFrameWidth / stepSize));           // 10
+		// (the adaptive mesh below picks the vertices it needs from the grid itself)
+		if (!adaptiveMesh && incrementalUpdates)
+		{
+			// filling can reach past the changed tiles, so also rebuild every tile it altered
+			if (enableNoiseSmoothing)
+				markChangedGridTiles(depthGrid.data(), mesh.getVertices().data(), dirtyTiles, pool);
+			depthGridToVertices(depthGrid.data(), sampling, mesh.getVertices().data(), dirtyTiles, pool);
 		}
+		else if (!adaptiveMesh)
+			depthGridToVertices(depthGrid.data(), sampling, mesh.getVertices().data(), pool);
 	}
 
+	// With adaptiveMesh the grid is triangulated as a restricted quadtree instead: full
+	// resolution only where the depth isn't planar to within adaptiveTolerance, a few large
+	// triangles on flat surfaces. Vertices and indices change every frame.
+	if (adaptiveMesh)
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Indices);
+		const int numVertices = quadtree.build(depthGrid.data(), sampling, adaptiveTolerance, mesh.getVertices().data(), mesh.getIndices());
+		mesh.updateVertices(numVertices);
+		mesh.updateIndices();
+		meshHasQuadtreeIndices = true;
+	}
+	else if (incrementalUpdates)
+		mesh.updateVertices(dirtyTiles);
+	else
+		mesh.updateVertices(columns * rows);
+
+	// Hand the finished mesh to the export thread, if a snapshot or stream wants it
+	geometryExporter.submit(mesh.getVertices(), mesh.getNumVertices(), mesh.getIndices(), mesh.getIndicesVersion(),
+		adaptiveMesh ? OF_PRIMITIVE_TRIANGLES : primativeModeIterator->second);
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-	ofEnableDepthTest();
-	ofBackgroundGradient(ofColor::black, ofColor::black, OF_GRADIENT_CIRCULAR);
-	
-	auto vertCount = mesh.getNumVertices();
-	auto centerIshNode = mesh.getVertex(vertCount / 2);
-
-	// even points can overlap with each other, let's avoid that
-	spot.enable();
-	cam.begin();
-
-	ofRotateZDeg(180);
-	ofRotateXDeg(270);
-	ofTranslate(-appWidth / 4 , 0, -appHeight/4);
-
-	meshMaterial.begin();
-	mesh.draw();
-	meshMaterial.end();
-	if (labelPoints)
+	if (options.headless)
+		return;
+
 	{
-		for (int i = 0; i < mesh.getNumVertices(); i++)
+		ScopedStageTimer timer(profiler, StageProfiler::Upload);
+		mesh.upload();
+	}
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Draw);
+		ofEnableDepthTest();
+		ofBackgroundGradient(ofColor::black, ofColor::black, OF_GRADIENT_CIRCULAR);
+
+
+		// even points can overlap with each other, let's avoid that
+		spot.enable();
+		cam.begin();
+
+		ofRotateZDeg(180);
+		ofRotateXDeg(270);
+		ofTranslate(-appWidth / 4 , 0, -appHeight/4);
+
+		const auto mode = adaptiveMesh ? OF_PRIMITIVE_TRIANGLES : primativeModeIterator->second;
+		if (mode == OF_PRIMITIVE_POINTS)
 		{
-			auto vertX = mesh.getVertex(i).x;
-			auto vertY = mesh.getVertex(i).y;
-			auto vertZ = mesh.getVertex(i).z;
-			stringstream sPos;
-
-			/* uncomment for format: <point:x,y,z> */
-			sPos << i << ":" << vertX << "," << vertY << "," << vertZ << std::endl;
-			ofDrawBitmapString(sPos.str().c_str(), vertX + 1, vertY + 1, vertZ + 1);
-
-			/* uncomment for format: <point> */
-			/*
-			sPos << i << std::endl;
-			ofDrawBitmapString(sPos.str().c_str(), vertX + 1, vertY + 1, vertZ + 1);
-			*/
+			// the programmable renderer has no GL_POINT_SMOOTH, a shader draws the points
+			// round, unlit in the material's colour
+			ofSetColor(meshMaterial.getDiffuseColor());
+			roundPoints.begin(mesh.hasColor());
+			mesh.drawElements(mode);
+			roundPoints.end();
+			ofSetColor(ofColor::white);
 		}
-	}
-	cam.end();
+		else
+		{
+			meshMaterial.begin();
+			mesh.drawElements(mode);
+			meshMaterial.end();
+		}
+		if (labelPoints)
+		{
+			vertexLabels.update(mesh.getVertices().data(), mesh.getNumVertices());
+			vertexLabels.layout(labelDistance);
+		}
+		cam.end();
 
-	ofDisableDepthTest();
+		ofDisableDepthTest();
+		if (labelPoints)
+			vertexLabels.draw();
+	}
 	// Draw Text
+	ScopedStageTimer timer(profiler, StageProfiler::Hud);
 	stringstream ss;
 	ss << "Point Density (m, n): " << stepSize << std::endl;
 	ss << "minRawDepth (p,o): " << minRawDepth << std::endl;
 	ss << "maxnRawDepth (l,k): " << maxRawDepth << std::endl;
 	ss << "enableNoiseSmoothing (f): " << (enableNoiseSmoothing ? "true" : "false") << std::endl;
-	ss << "labelPoints (u): " << (labelPoints ? "true" : "false") << std::endl;
+	ss << "labelPoints (u): " << (labelPoints ? "true" : "false") << ", " << vertexLabels.getNumVisible() << " shown" << std::endl;
+	ss << "labelDistance (r,t): " << labelDistance << std::endl;
 	ss << "primativeMode (y): " << primativeModeIterator->first << std::endl;
+	ss << "parallelBuild (j): " << (parallelBuild ? workerPool->getNumThreads() : 1) << " threads" << std::endl;
+	ss << "depthPooling (b): " << getDepthPoolingName(depthPooling) << std::endl;
+	ss << "extrusion: " << getSimdPathName(getSupportedSimdPath()) << std::endl;
+	ss << "adaptiveMesh (c): " << (adaptiveMesh ? "true" : "false") << std::endl;
+	ss << "adaptiveTolerance (d,e): " << adaptiveTolerance << std::endl;
+	ss << "vertices: " << mesh.getNumVertices() << " of " << mesh.getColumns() * mesh.getRows() << std::endl;
+	ss << "incrementalUpdates (i): " << (incrementalUpdates ? "true" : "false") << std::endl;
+	ss << "changeThreshold (g,h): " << changeThreshold << " mm" << std::endl;
+	ss << "tiles touched: " << ofToString(dirtyTiles.getDirtyFraction() * 100, 1) << "% (avg "
+		<< ofToString(dirtyTiles.getCounters().getDirtyFraction() * 100, 1) << "%), frames skipped: "
+		<< dirtyTiles.getCounters().skippedFrames << "/" << dirtyTiles.getCounters().frames << std::endl;
+	ss << "capture dropped/duplicate: " << depthCapture.getDroppedFrames() << "/" << depthCapture.getDuplicateFrames() << std::endl;
+	ss << "recording (R): " << depthRecorder.getSummary() << std::endl;
+	ss << "export (S, E): " << geometryExporter.getSummary() << std::endl;
 	ss << "spotZ (q, w): " << spotZ << std::endl;
 	ss << "spotX (a, s): " << spotX << std::endl;
 	ss << "spotY (z, x): " << spotY << std::endl;
 	ofDrawBitmapStringHighlight(ss.str().c_str(), 20, 20, ofColor::white, ofColor::black);
+	profiler.draw(400, 20);
 
 	spot.disable();
 }
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+	depthCapture.stop();
+	depthRecorder.stop();
+	geometryExporter.stop();
+	ofLogNotice() << processedFrames << " frames from " << depthCapture.getSourceDescription()
+		<< ", " << depthCapture.getDroppedFrames() << " dropped";
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+	// Any setting can change the mesh, so rebuild every tile on the next frame
+	dirtyTiles.invalidate();
+
+	// Save the geometry as PLY
+	if (key == 'S')
+		geometryExporter.requestSnapshot("mesh_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".ply");
+
+	// Toggle streaming the geometry of every frame
+	if (key == 'E') {
+		if (geometryExporter.isStreaming())
+			geometryExporter.stopStream();
+		else
+			geometryExporter.startStream("mesh_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".pstream");
+	}
+
+	// Toggle recording the depth frames
+	if (key == 'R') {
+		if (depthRecorder.isRecording())
+			depthRecorder.stop();
+		else
+			depthRecorder.start(ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".rsdepth");
+	}
+
 	// Toggle Filtering
 	if (key == 'f')
 		enableNoiseSmoothing = !enableNoiseSmoothing;
 
+	// Toggle the parallel mesh build
+	if (key == 'j')
+		parallelBuild = !parallelBuild;
+
+	// Cycle the block pooling mode
+	if (key == 'b')
+		depthPooling = DepthPooling((int(depthPooling) + 1) % 4);
+
+	// Toggle incremental mesh updates
+	if (key == 'i') {
+		incrementalUpdates = !incrementalUpdates;
+		dirtyTiles.resetCounters();
+	}
+
+	// Increase Decrease changeThreshold
+	if (key == 'h') changeThreshold += 1;
+	if (key == 'g') {
+		if (changeThreshold > 0)
+			changeThreshold -= 1;
+	};
+
+	// Toggle the adaptive quadtree mesh
+	if (key == 'c')
+		adaptiveMesh = !adaptiveMesh;
+
+	// Increase Decrease adaptiveTolerance
+	if (key == 'e') adaptiveTolerance += 1;
+	if (key == 'd') {
+		if (adaptiveTolerance > 0)
+			adaptiveTolerance -= 1;
+	};
+
+	// Save the stage timings
+	if (key == 'v') {
+		const auto path = "stages_" + ofGetTimestampString() + ".csv";
+		if (profiler.saveCsv(path))
+			ofLogNotice() << "stage timings saved to " << path;
+	}
+
 	// Label Points
 	if (key == 'u')
 		labelPoints = !labelPoints;
 
+	// Increase Decrease labelDistance
+	if (key == 't') labelDistance += 100;
+	if (key == 'r') {
+		if (labelDistance > 100)
+			labelDistance -= 100;
+	};
+
 	// Cycle Primative Mode 
 	if (key == 'y') {
 		// MK NOTE: end() actually returns an iterator referring to the "past-the-end" element.
@@ -0,0 +1,90 @@
+#include "circlePool.h"
+
+CirclePool::CirclePool(int capacity, float maxSleepSeconds)
+	: m_maxSleepSeconds(maxSleepSeconds)
+	, m_soundData(capacity)
+{
+	// the SoundData slab is handed out as Box2D user data, so it must never move
+	m_slots.reserve(capacity);
+	m_parked.reserve(capacity);
+}
+
+ofxBox2dCircle& CirclePool::spawn(b2World* world, float x, float y, float radius)
+{
+	int index;
+	if (!m_parked.empty()) {
+		index = m_parked.back();
+		m_parked.pop_back();
+	}
+	else if (m_slots.size() < m_soundData.size()) {
+		index = int(m_slots.size());
+		m_slots.emplace_back();
+		auto c = std::make_shared<ofxBox2dCircle>();
+		c->setPhysics(1, 0.5, 0.9);
+		c->setup(world, x, y, radius);
+		c->setData(&m_soundData[index]);
+		m_slots[index].circle = c;
+	}
+	else {
+		auto oldest = std::min_element(m_slots.begin(), m_slots.end(), [](const Slot& a, const Slot& b) {
+			return a.spawnOrder < b.spawnOrder;
+		});
+		index = int(oldest - m_slots.begin());
+		m_numRecycled++;
+	}
+
+	auto& slot = m_slots[index];
+	auto& circle = *slot.circle;
+	if (slot.spawnOrder > 0) {
+		// reused: back into the simulation at rest
+		circle.setPosition(x, y);
+		circle.setVelocity(0, 0);
+		circle.setAngularVelocity(0);
+		circle.setRadius(radius);
+		circle.body->SetActive(true);
+		circle.body->SetAwake(true);
+	}
+	slot.live = true;
+	slot.asleepSince = -1;
+	slot.spawnOrder = ++m_numSpawned;
+
+	auto& sd = m_soundData[index];
+	sd.soundID = ofRandom(0, N_SOUNDS);
+	sd.bHit = false;
+	sd.slot = index;
+	return circle;
+}
+
+void CirclePool::recycle(const ofRectangle& bounds, float now)
+{
+	for (int i = 0; i < int(m_slots.size()); i++) {
+		auto& slot = m_slots[i];
+		if (!slot.live)
+			continue;
+
+		const auto position = slot.circle->getPosition();
+		const float radius = slot.circle->getRadius();
+		if (position.x < bounds.x - radius || position.x > bounds.x + bounds.width + radius ||
+			position.y > bounds.y + bounds.height + radius) {
+			park(i);
+			continue;
+		}
+
+		if (slot.circle->body->IsAwake())
+			slot.asleepSince = -1;
+		else if (slot.asleepSince < 0)
+			slot.asleepSince = now;
+		else if (now - slot.asleepSince > m_maxSleepSeconds)
+			park(i);
+	}
+}
+
+void CirclePool::park(int index)
+{
+	auto& slot = m_slots[index];
+	slot.circle->body->SetActive(false);
+	slot.live = false;
+	m_soundData[index].bHit = false;
+	m_parked.push_back(index);
+	m_numRecycled++;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxBox2d.h"
+
+#define N_SOUNDS 5
+
+class SoundData {
+public:
+	int	 soundID;
+	bool bHit;
+	int  slot; // the circle's, for the collision sounds
+};
+
+// A capped set of ofxBox2dCircle bodies, each with a SoundData from a slab
+// that is never reallocated. Circles are never destroyed: recycle() parks the
+// ones that left the window or slept too long by taking their body out of the
+// simulation, and spawn() wakes a parked one before creating another. At
+// capacity spawn() moves the oldest live circle instead.
+class CirclePool
+{
+
+public:
+	CirclePool(int capacity, float maxSleepSeconds);
+
+	// The circle now live at x, y, with a new random sound.
+	ofxBox2dCircle& spawn(b2World* world, float x, float y, float radius);
+
+	// Parks live circles that left bounds through the sides or the bottom (new
+	// ones fall in from above), or that have been asleep for longer than
+	// maxSleepSeconds by now.
+	void recycle(const ofRectangle& bounds, float now);
+
+	// function(slot, circle, soundData) for every live circle
+	template<typename Function>
+	void forEachLive(Function function)
+	{
+		for (int i = 0; i < int(m_slots.size()); i++) {
+			if (m_slots[i].live)
+				function(i, *m_slots[i].circle, m_soundData[i]);
+		}
+	}
+
+	// Tells a slot's circles apart: different for every spawn, 0 for none yet.
+	uint64_t getSpawnOrder(int slot) const { return m_slots[slot].spawnOrder; }
+
+	int getCapacity() const { return int(m_soundData.size()); }
+	int getNumLive() const { return int(m_slots.size() - m_parked.size()); }
+	int getNumPooled() const { return int(m_parked.size()); }
+	int getNumRecycled() const { return m_numRecycled; }
+
+private:
+	struct Slot
+	{
+		std::shared_ptr<ofxBox2dCircle> circle;
+		bool live = false;
+		float asleepSince = -1;
+		uint64_t spawnOrder = 0;
+	};
+
+	void park(int index);
+
+	float m_maxSleepSeconds;
+	std::vector<Slot> m_slots;
+	std::vector<SoundData> m_soundData; // one per slot, sized to capacity up front
+	std::vector<int> m_parked;
+	uint64_t m_numSpawned = 0;
+	int m_numRecycled = 0;
+};
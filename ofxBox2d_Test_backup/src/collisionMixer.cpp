@@ -0,0 +1,92 @@
+#include "collisionMixer.h"
+
+namespace {
+	const float never = -1e9f; // played at, for bodies and sounds that never were
+}
+
+CollisionMixer::CollisionMixer(int maxVoices, float bodyWindow, float soundWindow, uint32_t queueCapacity)
+	: m_maxVoices(std::max(1, maxVoices))
+	, m_bodyWindow(bodyWindow)
+	, m_soundWindow(soundWindow)
+	, m_voices(m_maxVoices)
+	, m_hits(queueCapacity)
+{
+}
+
+void CollisionMixer::load(const std::vector<std::string>& paths)
+{
+	m_numSounds = int(paths.size());
+	m_players.clear();
+	m_players.resize(m_maxVoices * m_numSounds);
+	for (int voice = 0; voice < m_maxVoices; voice++) {
+		for (int sound = 0; sound < m_numSounds; sound++) {
+			auto& player = getPlayer(voice, sound);
+			player.load(paths[sound]);
+			player.setMultiPlay(false);
+			player.setLoop(false);
+		}
+	}
+	m_soundPlayedAt.assign(m_numSounds, never);
+}
+
+bool CollisionMixer::post(int body, int sound)
+{
+	if (m_hits.push(Hit{ body, sound }))
+		return true;
+	m_dropped++;
+	return false;
+}
+
+void CollisionMixer::update(float now)
+{
+	Hit hit;
+	while (m_hits.pop(hit)) {
+		if (hit.body < 0 || hit.sound < 0 || hit.sound >= m_numSounds)
+			continue;
+		if (hit.body >= int(m_bodyPlayedAt.size()))
+			m_bodyPlayedAt.resize(hit.body + 1, never);
+		if (now - m_bodyPlayedAt[hit.body] < m_bodyWindow || now - m_soundPlayedAt[hit.sound] < m_soundWindow) {
+			m_coalesced++;
+			continue;
+		}
+		m_bodyPlayedAt[hit.body] = now;
+		m_soundPlayedAt[hit.sound] = now;
+		play(hit.sound, now);
+	}
+
+	m_activeVoices = 0;
+	for (int voice = 0; voice < m_maxVoices; voice++) {
+		if (isPlaying(voice))
+			m_activeVoices++;
+	}
+}
+
+bool CollisionMixer::isPlaying(int voice)
+{
+	const int sound = m_voices[voice].sound;
+	return sound >= 0 && getPlayer(voice, sound).isPlaying();
+}
+
+void CollisionMixer::play(int sound, float now)
+{
+	// a free voice, else the one playing the longest
+	int chosen = -1;
+	for (int voice = 0; voice < m_maxVoices && chosen < 0; voice++) {
+		if (!isPlaying(voice))
+			chosen = voice;
+	}
+	if (chosen < 0) {
+		chosen = 0;
+		for (int voice = 1; voice < m_maxVoices; voice++) {
+			if (m_voices[voice].startedAt < m_voices[chosen].startedAt)
+				chosen = voice;
+		}
+		getPlayer(chosen, m_voices[chosen].sound).stop();
+		m_stolen++;
+	}
+
+	m_voices[chosen].sound = sound;
+	m_voices[chosen].startedAt = now;
+	getPlayer(chosen, sound).play();
+	m_played++;
+}
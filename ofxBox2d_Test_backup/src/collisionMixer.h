@@ -0,0 +1,63 @@
+#pragma once
+#include "ofMain.h"
+#include "spscQueue.h"
+
+// Plays the collision sounds on the main thread. The physics thread posts a
+// hit per circle into a lock-free queue; update() drains it, drops hits of a
+// circle that already sounded within bodyWindow seconds and of a sound that
+// started within soundWindow seconds, and plays the rest on at most maxVoices
+// voices, stopping the one that started first when they are all busy.
+class CollisionMixer
+{
+
+public:
+	CollisionMixer(int maxVoices, float bodyWindow, float soundWindow, uint32_t queueCapacity = 1024);
+
+	// Loads every sound once per voice.
+	void load(const std::vector<std::string>& paths);
+
+	// Physics thread. Returns false, dropping the hit, if the queue is full.
+	bool post(int body, int sound);
+
+	// Main thread, once a frame.
+	void update(float now);
+
+	int getMaxVoices() const { return m_maxVoices; }
+	int getActiveVoices() const { return m_activeVoices; }
+	uint64_t getPlayed() const { return m_played; }
+	uint64_t getCoalesced() const { return m_coalesced; }
+	uint64_t getStolen() const { return m_stolen; }
+	uint64_t getDropped() const { return m_dropped; }
+
+private:
+	struct Hit
+	{
+		int body;
+		int sound;
+	};
+	struct Voice
+	{
+		int sound = -1; // none yet
+		float startedAt = 0;
+	};
+
+	ofSoundPlayer& getPlayer(int voice, int sound) { return m_players[voice * m_numSounds + sound]; }
+	bool isPlaying(int voice);
+	void play(int sound, float now);
+
+	int m_maxVoices;
+	float m_bodyWindow;
+	float m_soundWindow;
+	int m_numSounds = 0;
+	std::vector<ofSoundPlayer> m_players; // numSounds per voice
+	std::vector<Voice> m_voices;
+	std::vector<float> m_bodyPlayedAt;  // by body, grows as bodies show up
+	std::vector<float> m_soundPlayedAt;
+	SpscQueue<Hit> m_hits;
+
+	int m_activeVoices = 0;
+	uint64_t m_played = 0;
+	uint64_t m_coalesced = 0;
+	uint64_t m_stolen = 0;
+	std::atomic<uint64_t> m_dropped{ 0 };
+};
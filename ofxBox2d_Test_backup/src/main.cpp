@@ -1,7 +1,20 @@
 #include "ofMain.h"
+#include "ofAppNoWindow.h"
 #include "ofApp.h"
 
-int main() {
-    ofSetupOpenGL(1280, 720, OF_WINDOW);
-	ofRunApp(new ofApp());
+int main(int argc, char* argv[]) {
+	const auto options = AppOptions::parse(argc, argv);
+	if (options.headless)
+		ofSetupOpenGL(std::make_shared<ofAppNoWindow>(), 1280, 720, OF_WINDOW);
+	else {
+		// the programmable renderer, for CircleBatch's instanced draw
+		ofGLWindowSettings settings;
+		settings.setGLVersion(3, 3);
+		settings.setSize(1280, 720);
+		ofCreateWindow(settings);
+	}
+
+	auto app = new ofApp();
+	app->options = options;
+	ofRunApp(app);
 }
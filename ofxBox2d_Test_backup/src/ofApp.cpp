@@ -1,8 +1,18 @@
 #include "ofApp.h"
 
+namespace {
+	bool solidSilhouettes = true;
+	ContourSettings contourSettings;
+	const ofFloatColor hitColor = ofFloatColor::fromHex(0xff0000);
+	const ofFloatColor circleColor = ofFloatColor::fromHex(0x4ccae9);
+}
+
 //--------------------------------------------------------------
 void ofApp::setup() {
-	rs2_pipe.start();
+	depthCapture.setProfiler(&profiler);
+	depthCapture.start(createDepthSource(options.depthSource));
+	if (!options.record.empty())
+		depthRecorder.start(options.record);
 	
 	ofSetVerticalSync(true);
 	ofBackgroundHex(0xfdefc2);
@@ -11,19 +21,26 @@ void ofApp::setup() {
     box2d.enableEvents();   // <-- turn on the event listener
 	box2d.setGravity(0, 10);
 	box2d.createGround();
-	box2d.setFPS(60.0);
-	box2d.registerGrabbing();
 	
 	// register the listener so that we get the events
 	ofAddListener(box2d.contactStartEvents, this, &ofApp::contactStart);
 	ofAddListener(box2d.contactEndEvents, this, &ofApp::contactEnd);
 
 	// load the 8 sfx soundfile
+	std::vector<std::string> sfx;
 	for (int i=0; i<N_SOUNDS; i++) {
-		sound[i].load("sfx/"+ofToString(i)+".mp3");
-		sound[i].setMultiPlay(true);
-		sound[i].setLoop(false);
+		sfx.push_back("sfx/"+ofToString(i)+".mp3");
 	}
+	mixer.load(sfx);
+
+	// from here on only the physics thread touches the world; grabbing goes
+	// through sendInput() instead of box2d.registerGrabbing()
+	windowWidth = ofGetWidth();
+	windowHeight = ofGetHeight();
+	physics.setProfiler(&profiler);
+	physics.start(box2d, 60, 2,
+		[this](double time) { physicsBeforeStep(time); },
+		[this]() { physicsAfterStep(); });
 }
 
 
@@ -38,14 +55,15 @@ void ofApp::contactStart(ofxBox2dContactArgs &e) {
 			SoundData * aData = (SoundData*)e.a->GetBody()->GetUserData();
 			SoundData * bData = (SoundData*)e.b->GetBody()->GetUserData();
 			
+			// played by update() on the main thread
 			if(aData) {
 				aData->bHit = true;
-				sound[aData->soundID].play();
+				mixer.post(aData->slot, aData->soundID);
 			}
 			
 			if(bData) {
 				bData->bHit = true;
-				sound[bData->soundID].play();
+				mixer.post(bData->slot, bData->soundID);
 			}
 		}
 	}
@@ -72,64 +90,220 @@ void ofApp::contactEnd(ofxBox2dContactArgs &e) {
 
 //--------------------------------------------------------------
 void ofApp::update() {
-	
-	box2d.update();
-	
+	windowWidth = ofGetWidth();
+	windowHeight = ofGetHeight();
+
+	// the sounds of the contacts since the last frame
+	mixer.update(ofGetElapsedTimef());
+
+	// Pick up the newest depth frame from the capture thread without blocking.
+	// Physics keeps running on the last mapped depth until a new one arrives.
+	rs2::frame frame = depthCapture.getLatestFrame();
+	if (frame) {
+		rs2::depth_frame depth = frame;
+		depthRecorder.add(depth);
+		const auto view = DepthView::fromFrame(depth);
+		{
+			ScopedStageTimer timer(profiler, StageProfiler::DepthConversion);
+			ofApp::calculateDepth(depth);
+			radiusMailbox = avg_dist_mapped;
+			if (solidSilhouettes) {
+				depthContours.update(view, depth.get_units(), contourSettings);
+				sendSilhouettes(depthContours.getNumContours(), glm::vec2(float(ofGetWidth()) / view.width, float(ofGetHeight()) / view.height));
+			}
+		}
+
+		processedFrames++;
+		if (options.frames > 0 && processedFrames >= options.frames)
+			ofExit();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::physicsBeforeStep(double time) {
+	{
+		std::lock_guard<std::mutex> lock(inputMutex);
+		std::swap(pendingInput, physicsInput);
+	}
+	for (const auto& input : physicsInput) {
+		switch (input.type) {
+		case PhysicsInput::Spawn: circles.spawn(box2d.getWorld(), input.x, input.y, resizer.getTarget()); break;
+		case PhysicsInput::GrabDown: box2d.grabShapeDown(input.x, input.y); break;
+		case PhysicsInput::GrabDragged: box2d.grabShapeDragged(input.x, input.y); break;
+		case PhysicsInput::GrabUp: box2d.grabShapeUp(input.x, input.y); break;
+		case PhysicsInput::EnableEvents: box2d.enableEvents(); break;
+		case PhysicsInput::DisableEvents: box2d.disableEvents(); break;
+		}
+	}
+	physicsInput.clear();
+
+	// circles that fell out of the window or came to rest go back to the pool
+	const ofRectangle bounds(0, 0, windowWidth, windowHeight);
+	circles.recycle(bounds, time);
+
 	// add some circles every so often
 	if((int)ofRandom(0, 20) == 0) {
-		
-        auto c = std::make_shared<ofxBox2dCircle>();
-        c->setPhysics(1, 0.5, 0.9);
-        c->setup(box2d.getWorld(), (ofGetWidth()/2)+ofRandom(-30, 30), -20, ofRandom(20, 50));
-
-        c->setData(new SoundData());
-        auto * sd = (SoundData*)c->getData();
-        sd->soundID = ofRandom(0, N_SOUNDS);
-        sd->bHit    = false;
-        
-        circles.push_back(c);
+		circles.spawn(box2d.getWorld(), (bounds.width/2)+ofRandom(-30, 30), -20, resizer.getTarget());
 	}
 
+	// new circles are born at the target, so only a moved target costs fixture rebuilds
+	resizer.update(radiusMailbox);
+	resizer.apply(circles);
 
-	// Block program until frames arrive
-	rs2::frameset frames = rs2_pipe.wait_for_frames();
-	// Try to get a frame of a depth image
-	rs2::depth_frame depth = frames.get_depth_frame();
+	if (silhouetteMailbox.fetch()) {
+		const auto& mail = silhouetteMailbox.getReadBuffer();
+		silhouetteRebuilt = silhouette.update(box2d.getWorld(), mail.outlines, mail.count, mail.scale);
+	}
+}
 
-	auto avg_dist_mapped = ofApp::calculateDepth(depth);
+//--------------------------------------------------------------
+void ofApp::physicsAfterStep() {
+	auto& snapshot = snapshots.getWriteBuffer();
+	snapshot.current.assign(circles.getCapacity(), CircleState());
+	circles.forEachLive([&](int slot, ofxBox2dCircle& circle, SoundData& data) {
+		auto& body = snapshot.current[slot];
+		const auto position = circle.getPosition();
+		body.position = glm::vec2(position.x, position.y);
+		body.radius = circle.getRadius();
+		body.spawnOrder = circles.getSpawnOrder(slot);
+		body.hit = data.bHit;
+	});
+	snapshot.previous = lastBodies;
+	lastBodies = snapshot.current;
+	snapshot.time = std::chrono::steady_clock::now();
+
+	snapshot.numOutlines = silhouette.getNumChains();
+	if (int(snapshot.outlines.size()) < snapshot.numOutlines)
+		snapshot.outlines.resize(snapshot.numOutlines);
+	for (int i = 0; i < snapshot.numOutlines; i++)
+		snapshot.outlines[i] = silhouette.getOutline(i);
+
+	snapshot.live = circles.getNumLive();
+	snapshot.pooled = circles.getNumPooled();
+	snapshot.recycled = circles.getNumRecycled();
+	snapshot.rebuilt = silhouetteRebuilt;
+	snapshot.radius = resizer.getTarget();
+	snapshot.resized = resizer.getLastResized();
+	snapshot.totalResized = resizer.getTotalResized();
+	snapshots.publish();
+}
 
-	for (auto& circle : circles) {
-		circle->setRadius(avg_dist_mapped);
-	}
+//--------------------------------------------------------------
+void ofApp::sendInput(PhysicsInput::Type type, float x, float y) {
+	std::lock_guard<std::mutex> lock(inputMutex);
+	pendingInput.push_back({ type, x, y });
+}
 
+//--------------------------------------------------------------
+void ofApp::sendSilhouettes(int count, glm::vec2 scale) {
+	auto& mail = silhouetteMailbox.getWriteBuffer();
+	mail.count = count;
+	mail.scale = scale;
+	if (int(mail.outlines.size()) < count)
+		mail.outlines.resize(count);
+	for (int i = 0; i < count; i++)
+		mail.outlines[i] = depthContours.getContours()[i];
+	silhouetteMailbox.publish();
 }
 
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+	if (options.headless)
+		return;
 	
 	
-	for(size_t i=0; i<circles.size(); i++) {
-		ofFill();
-		SoundData * data = (SoundData*)circles[i].get()->getData();
-		
-		if(data && data->bHit) ofSetHexColor(0xff0000);
-		else ofSetHexColor(0x4ccae9);
-		
+	{
+		ScopedStageTimer timer(profiler, StageProfiler::Draw);
+		// the newest tick, blended with the one before by how far into the
+		// next tick we are, so motion stays smooth at any frame rate
+		snapshots.fetch();
+		const auto& snapshot = snapshots.getReadBuffer();
+		const float alpha = ofClamp(std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot.time).count() * physics.getRate(), 0, 1);
+		circleBatch.clear();
+		addInterpolatedCircles(circleBatch, snapshot.previous, snapshot.current, alpha, circleColor, hitColor);
+		circleBatch.draw();
+	
+		ofSetHexColor(0x444342);
+		for (int i = 0; i < snapshot.numOutlines; i++) {
+			const auto& outline = snapshot.outlines[i];
+			for (size_t j = 0; j < outline.size(); j++) {
+				const auto& next = outline[(j + 1) % outline.size()];
+				ofDrawLine(outline[j].x, outline[j].y, next.x, next.y);
+			}
+		}
 
-		circles[i].get()->draw();
+		auto ds = std::make_unique<DepthSquare>(400, 400, 40);
+		ds->setDepth(avg_dist);
+		ds->draw();
 	}
-	
-	auto ds = std::make_unique<DepthSquare>(400, 400, 40);
-	ds->setDepth(avg_dist);
-	ds->draw();
+
+	ScopedStageTimer timer(profiler, StageProfiler::Hud);
+	string info = "";
+	info += "Capture dropped/duplicate: " + ofToString(depthCapture.getDroppedFrames()) + "/" + ofToString(depthCapture.getDuplicateFrames()) + "\n";
+	info += "Recording (R): " + depthRecorder.getSummary() + "\n";
+	const auto& snapshot = snapshots.getReadBuffer();
+	info += "Circles live/pooled: " + ofToString(snapshot.live) + "/" + ofToString(snapshot.pooled)
+		+ " of " + ofToString(circles.getCapacity()) + ", recycled: " + ofToString(snapshot.recycled) + "\n";
+	info += "solidSilhouettes (e): " + string(solidSilhouettes ? "true" : "false") + ", " + ofToString(snapshot.numOutlines)
+		+ " chains, " + ofToString(snapshot.rebuilt) + " rebuilt\n";
+	info += "Radius target: " + ofToString(snapshot.radius, 1) + ", fixtures rebuilt: " + ofToString(snapshot.resized)
+		+ " last tick, " + ofToString(snapshot.totalResized) + " total\n";
+	info += "Sound voices: " + ofToString(mixer.getActiveVoices()) + "/" + ofToString(mixer.getMaxVoices())
+		+ ", played: " + ofToString(mixer.getPlayed()) + ", coalesced: " + ofToString(mixer.getCoalesced())
+		+ ", stolen: " + ofToString(mixer.getStolen()) + ", dropped: " + ofToString(mixer.getDropped()) + "\n";
+	info += "vertexBudget (b,n): " + ofToString(depthContours.getNumVertices()) + " of " + ofToString(contourSettings.vertexBudget) + "\n";
+	const auto step = profiler.getPercentiles(StageProfiler::Physics);
+	info += "Physics step p50/p95: " + ofToString(step.p50, 2) + "/" + ofToString(step.p95, 2) + " ms, "
+		+ ofToString(physics.getTicks()) + " ticks at " + ofToString(physics.getRate()) + "Hz, " + ofToString(physics.getSkippedTicks()) + " skipped\n";
+	ofSetHexColor(0x444342);
+	ofDrawBitmapString(info, 30, 60);
+	profiler.draw(300, 30);
+}
+
+//--------------------------------------------------------------
+void ofApp::exit() {
+	physics.stop();
+	depthCapture.stop();
+	depthRecorder.stop();
+	ofLogNotice() << processedFrames << " frames from " << depthCapture.getSourceDescription()
+		<< ", " << circles.getNumLive() << " circles live, " << circles.getNumRecycled() << " recycled";
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
 	if(key == 't') ofToggleFullscreen();
-    if(key == '1') box2d.enableEvents();
-    if(key == '2') box2d.disableEvents();
+    if(key == '1') sendInput(PhysicsInput::EnableEvents, 0, 0);
+    if(key == '2') sendInput(PhysicsInput::DisableEvents, 0, 0);
+
+	// Toggle the depth silhouette edges
+	if (key == 'e') {
+		solidSilhouettes = !solidSilhouettes;
+		if (!solidSilhouettes)
+			sendSilhouettes(0, glm::vec2(1, 1));
+	}
+
+	// Increase Decrease vertexBudget
+	if (key == 'n') contourSettings.vertexBudget += 20;
+	if (key == 'b') {
+		if (contourSettings.vertexBudget > 20)
+			contourSettings.vertexBudget -= 20;
+	};
+
+	// Toggle recording the depth frames
+	if (key == 'R') {
+		if (depthRecorder.isRecording())
+			depthRecorder.stop();
+		else
+			depthRecorder.start(ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".rsdepth");
+	}
+
+	// Save the stage timings
+	if (key == 'v') {
+		const auto path = "stages_" + ofGetTimestampString() + ".csv";
+		if (profiler.saveCsv(path))
+			ofLogNotice() << "stage timings saved to " << path;
+	}
     
 }
 
@@ -144,25 +318,18 @@ void ofApp::mouseMoved(int x, int y ) {
 
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button) {
+	sendInput(PhysicsInput::GrabDragged, x, y);
 }
 
 //--------------------------------------------------------------
 void ofApp::mousePressed(int x, int y, int button) {
-    
-    auto c = std::make_shared<ofxBox2dCircle>();
-    c->setPhysics(1, 0.5, 0.9);
-    c->setup(box2d.getWorld(), x, y, ofRandom(20, 50));
-    
-    c->setData(new SoundData());
-    auto * sd = (SoundData*)c->getData();
-    sd->soundID = ofRandom(0, N_SOUNDS);
-    sd->bHit	= false;
-    
-    circles.push_back(c);
+	sendInput(PhysicsInput::GrabDown, x, y);
+	sendInput(PhysicsInput::Spawn, x, y);
 }
 
 //--------------------------------------------------------------
 void ofApp::mouseReleased(int x, int y, int button) {
+	sendInput(PhysicsInput::GrabUp, x, y);
 }
 
 //--------------------------------------------------------------
@@ -176,36 +343,10 @@ float ofApp::calculateDepth(const rs2::depth_frame& depthFrame)
 	*/
 	const auto rows = 10;
 	const auto cols = 10;
-	const auto num_cells = rows * cols;
-	std::vector<float> distances;
-
-	// Get the depth frame's dimensions
-	float width = depthFrame.get_width();
-	float height = depthFrame.get_height();
-
-	const auto window_corner_x = (width / 2) - (1 / 2 * cols);
-	const auto window_corner_y = (height / 2) - (1 / 2 * rows);
-
-
-	for (auto i = 0; i < rows; i++)
-	{
-		for (auto j = 0; j < cols; j++)
-		{
-			auto sample_cell_x = window_corner_x + j;
-			auto sample_cell_y = window_corner_y + i;
-			float dist_at_cell = depthFrame.get_distance(sample_cell_x, sample_cell_y);
-			distances.push_back(dist_at_cell);
-		}
-	}
-
-	// filter out zeros using `Erase-remove idiom`
-	distances.erase(std::remove_if(distances.begin(), distances.end(), [](float distance) {return distance < 0.1; }), distances.end());
-	float sum = 0;
-	for (auto& distance_sample : distances) {
-		sum += distance_sample;
-	}
-	auto average_distance = sum / distances.size();
-	avg_dist = average_distance;
+	const auto depth = DepthView::fromFrame(depthFrame);
+	roiStats.update(depth, depthFrame.get_units());
+	const auto roi = roiStats.query((depth.width - cols) / 2, (depth.height - rows) / 2, cols, rows);
+	avg_dist = roi.mean;
 	if (std::isnan(avg_dist))
 		avg_dist = 0.05;
 	if (std::isinf(avg_dist))
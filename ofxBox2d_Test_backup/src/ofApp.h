@@ -3,14 +3,52 @@
 #include "ofMain.h"
 #include "ofxBox2d.h"
 #include "depthSquare.h"
+#include "appOptions.h"
+#include "depthCapture.h"
+#include "depthRecorder.h"
+#include "depthRoi.h"
+#include "stageProfiler.h"
+#include "circleBatch.h"
+#include "circlePool.h"
+#include "collisionMixer.h"
+#include "resizeScheduler.h"
+#include "depthContours.h"
+#include "silhouetteEdges.h"
+#include "physicsThread.h"
+#include "tripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
+// Input from the main thread that touches the world, for the physics thread.
+struct PhysicsInput {
+	enum Type { Spawn, GrabDown, GrabDragged, GrabUp, EnableEvents, DisableEvents };
+	Type type;
+	float x;
+	float y;
+};
 
-#define N_SOUNDS 5
+// The depth silhouettes for the physics thread.
+struct SilhouetteMail {
+	std::vector<std::vector<glm::vec2>> outlines; // depth frame pixels, first count valid
+	int count = 0;
+	glm::vec2 scale; // to window coordinates
+};
 
-class SoundData {
-public:
-	int	 soundID;
-	bool bHit;
+// What the physics thread hands draw() after every tick.
+struct PhysicsSnapshot {
+	std::vector<CircleState> previous; // per CirclePool slot, the tick before
+	std::vector<CircleState> current;
+	std::chrono::steady_clock::time_point time; // of current
+	std::vector<std::vector<glm::vec2>> outlines; // window coordinates, first numOutlines valid
+	int numOutlines = 0;
+	int live = 0;
+	int pooled = 0;
+	int recycled = 0;
+	int rebuilt = 0;
+	float radius = 20; // the circles' target radius
+	int resized = 0;   // fixtures rebuilt by the tick
+	uint64_t totalResized = 0;
 };
 
 // -------------------------------------------------
@@ -21,6 +59,7 @@ public:
 	void setup();
 	void update();
 	void draw();
+	void exit();
 	
 	void keyPressed(int key);
 	void keyReleased(int key);
@@ -31,20 +70,53 @@ public:
 	void resized(int w, int h);
 
 	float calculateDepth(const rs2::depth_frame& depthFrame);
+
+	// run on the physics thread, around every world step
+	void physicsBeforeStep(double time);
+	void physicsAfterStep();
+
+	// hand world changes to the physics thread
+	void sendInput(PhysicsInput::Type type, float x, float y);
+	void sendSilhouettes(int count, glm::vec2 scale);
 	
 	// this is the function for contacts
 	void contactStart(ofxBox2dContactArgs &e);
 	void contactEnd(ofxBox2dContactArgs &e);
 
-	// when the ball hits we play this sound
-	ofSoundPlayer  sound[N_SOUNDS];
+	// when the ball hits we play this sound, on at most 8 voices, once per
+	// circle every 250ms and once per sound every 50ms
+	CollisionMixer mixer{ 8, 0.25, 0.05 };
 	
 	ofxBox2d                                box2d;			//	the box2d world
-	vector		<shared_ptr<ofxBox2dCircle> >	circles;	//	default box2d circles
+	PhysicsThread                           physics;		//	which only its thread touches once started
+	CirclePool                              circles{ 300, 5 };	//	default box2d circles, at most 300, parked after 5s asleep
+	ResizeScheduler                         resizer{ 0.2, 2, 32 };	//	follows avg_dist_mapped past a 2px band, 32 circles a tick
+	CircleBatch                             circleBatch;	//	draws them all in one call
+	DepthContours                           depthContours;	//	outlines of what's in front of the sensor
+	SilhouetteEdges                         silhouette{ 4 };	//	and their edge chains, rebuilt once they moved 4px
+	int                                     silhouetteRebuilt = 0;	//	physics thread
+
+	// main thread to physics thread
+	std::atomic<float>                      radiusMailbox{ 20 };	//	avg_dist_mapped
+	std::atomic<int>                        windowWidth{ 0 };
+	std::atomic<int>                        windowHeight{ 0 };
+	std::mutex                              inputMutex;
+	std::vector<PhysicsInput>               pendingInput;	//	guarded by inputMutex
+	std::vector<PhysicsInput>               physicsInput;	//	physics thread
+	TripleBuffer<SilhouetteMail>            silhouetteMailbox;
+
+	// physics thread to main thread
+	TripleBuffer<PhysicsSnapshot>           snapshots;
+	std::vector<CircleState>                  lastBodies;		//	physics thread
 
-	double avg_dist;
-	float avg_dist_mapped;
-	rs2::pipeline rs2_pipe;
+	double avg_dist = 0;
+	float avg_dist_mapped = 20; // low end of the mapped range until the first frame arrives
+	AppOptions options;
+	DepthCapture depthCapture;
+	DepthRecorder depthRecorder;
+	DepthRoiStats roiStats{ 0.1f, 4.0f, 0 }; // calculateDepth() only reads the mean, no median tables
+	StageProfiler profiler;
+	int processedFrames = 0;
 	
 };
 
@@ -0,0 +1,62 @@
+#include "physicsThread.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+	// how far behind the thread may fall before it gives up on catching up
+	const int maxLateTicks = 3;
+}
+
+PhysicsThread::~PhysicsThread()
+{
+	stop();
+}
+
+void PhysicsThread::start(ofxBox2d& box2d, double rate, int subSteps,
+	std::function<void(double)> beforeStep, std::function<void()> afterStep)
+{
+	if (m_started)
+		return;
+	m_box2d = &box2d;
+	m_rate = rate;
+	m_subSteps = std::max(1, subSteps);
+	m_beforeStep = std::move(beforeStep);
+	m_afterStep = std::move(afterStep);
+	// ofxBox2d::update() steps by 1 / fps
+	m_box2d->setFPS(float(m_rate * m_subSteps));
+	m_started = true;
+	startThread();
+}
+
+void PhysicsThread::stop()
+{
+	if (!m_started)
+		return;
+	waitForThread(true);
+	m_started = false;
+}
+
+void PhysicsThread::threadedFunction()
+{
+	using Clock = std::chrono::steady_clock;
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / m_rate));
+	auto next = Clock::now();
+	while (isThreadRunning()) {
+		std::this_thread::sleep_until(next);
+		{
+			ScopedStageTimer timer(m_profiler, StageProfiler::Physics);
+			m_beforeStep(m_ticks / m_rate);
+			for (int i = 0; i < m_subSteps; i++)
+				m_box2d->update();
+			m_afterStep();
+		}
+		m_ticks++;
+
+		next += period;
+		const auto late = Clock::now() - next;
+		if (late > period * maxLateTicks) {
+			m_skippedTicks += late / period;
+			next = Clock::now();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxBox2d.h"
+#include "stageProfiler.h"
+#include <atomic>
+#include <functional>
+
+// Steps an ofxBox2d world on its own thread at a fixed rate, so neither slow
+// depth frames nor a slow draw() stretch the simulation. Every tick calls
+// beforeStep, steps the world subSteps times by 1 / (rate * subSteps) seconds
+// and calls afterStep. While the thread runs, those two callbacks (and the
+// contact events the steps fire) are the only place the world may be touched.
+// After a stall the thread skips the ticks it missed instead of running them
+// back to back.
+class PhysicsThread : public ofThread
+{
+
+public:
+	~PhysicsThread();
+
+	// beforeStep gets the simulation time in seconds.
+	void start(ofxBox2d& box2d, double rate, int subSteps,
+		std::function<void(double)> beforeStep, std::function<void()> afterStep);
+	void stop();
+
+	// Ticks are recorded as StageProfiler::Physics. Set before start().
+	void setProfiler(StageProfiler* profiler) { m_profiler = profiler; }
+
+	double getRate() const { return m_rate; }
+	uint64_t getTicks() const { return m_ticks; }
+	uint64_t getSkippedTicks() const { return m_skippedTicks; }
+
+protected:
+	void threadedFunction() override;
+
+private:
+	ofxBox2d* m_box2d = nullptr;
+	double m_rate = 60;
+	int m_subSteps = 1;
+	std::function<void(double)> m_beforeStep;
+	std::function<void()> m_afterStep;
+	StageProfiler* m_profiler = nullptr;
+	std::atomic<uint64_t> m_ticks{ 0 };
+	std::atomic<uint64_t> m_skippedTicks{ 0 };
+	bool m_started = false;
+};
@@ -0,0 +1,45 @@
+#include "resizeScheduler.h"
+
+ResizeScheduler::ResizeScheduler(float smoothing, float hysteresis, int maxPerTick)
+	: m_smoothing(ofClamp(smoothing, 0, 1))
+	, m_hysteresis(hysteresis)
+	, m_maxPerTick(std::max(1, maxPerTick))
+{
+}
+
+bool ResizeScheduler::update(float radius)
+{
+	if (m_smoothed < 0)
+		m_smoothed = radius;
+	else
+		m_smoothed += m_smoothing * (radius - m_smoothed);
+
+	if (std::abs(m_smoothed - m_target) <= m_hysteresis)
+		return false;
+	m_target = m_smoothed;
+	return true;
+}
+
+int ResizeScheduler::apply(CirclePool& circles)
+{
+	// off target circles from the cursor to the end of the pool first, then
+	// from the start, so every one gets its turn
+	int resized = 0;
+	int lastSlot = -1;
+	for (int pass = 0; pass < 2 && resized < m_maxPerTick; pass++) {
+		circles.forEachLive([&](int slot, ofxBox2dCircle& circle, SoundData&) {
+			const bool inPass = pass == 0 ? slot >= m_cursor : slot < m_cursor;
+			if (!inPass || resized >= m_maxPerTick || circle.getRadius() == m_target)
+				return;
+			circle.setRadius(m_target);
+			resized++;
+			lastSlot = slot;
+		});
+	}
+	if (lastSlot >= 0)
+		m_cursor = lastSlot + 1;
+
+	m_lastResized = resized;
+	m_totalResized += resized;
+	return resized;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "circlePool.h"
+
+// Decides when the circles follow the depth-mapped radius, since every
+// setRadius() rebuilds a body's fixture. The input is smoothed with an
+// exponential moving average, and the target radius only moves once the
+// smoothed value leaves a hysteresis band around it. apply() then resizes at
+// most maxPerTick circles a tick, carrying on round the pool where the last
+// tick stopped, so a change reaches every circle over a few ticks without
+// rebuilding them all at once.
+class ResizeScheduler
+{
+
+public:
+	ResizeScheduler(float smoothing, float hysteresis, int maxPerTick);
+
+	// Takes the newest radius. Returns true if the target moved.
+	bool update(float radius);
+
+	// Resizes live circles that are off target, up to maxPerTick of them.
+	// Returns how many were resized.
+	int apply(CirclePool& circles);
+
+	float getTarget() const { return m_target; }
+	float getSmoothed() const { return m_smoothed; }
+	int getLastResized() const { return m_lastResized; }
+	uint64_t getTotalResized() const { return m_totalResized; }
+
+private:
+	float m_smoothing;
+	float m_hysteresis;
+	int m_maxPerTick;
+	float m_smoothed = -1; // no input yet
+	float m_target = 20;
+	int m_cursor = 0; // slot after the last one resized
+	int m_lastResized = 0;
+	uint64_t m_totalResized = 0;
+};
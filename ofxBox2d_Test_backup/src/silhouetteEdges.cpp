@@ -0,0 +1,114 @@
+#include "silhouetteEdges.h"
+
+namespace {
+	glm::vec2 getCentroid(const std::vector<glm::vec2>& vertices)
+	{
+		glm::vec2 sum(0, 0);
+		for (const auto& vertex : vertices)
+			sum = sum + vertex;
+		return vertices.empty() ? sum : sum * (1.0f / vertices.size());
+	}
+
+	// distance from point to the closed outline through vertices
+	float distanceToOutline(glm::vec2 point, const std::vector<glm::vec2>& vertices)
+	{
+		float nearest = std::numeric_limits<float>::max();
+		for (size_t i = 0; i < vertices.size(); i++) {
+			const glm::vec2 a = vertices[i];
+			const glm::vec2 ab = vertices[(i + 1) % vertices.size()] - a;
+			const float lengthSquared = glm::dot(ab, ab);
+			const float t = lengthSquared > 0 ? ofClamp(glm::dot(point - a, ab) / lengthSquared, 0, 1) : 0;
+			nearest = std::min(nearest, glm::length(point - (a + ab * t)));
+		}
+		return nearest;
+	}
+
+	// every vertex of each outline within tolerance of the other outline
+	bool isSameOutline(const std::vector<glm::vec2>& a, const std::vector<glm::vec2>& b, float tolerance)
+	{
+		for (const auto& vertex : a) {
+			if (distanceToOutline(vertex, b) > tolerance)
+				return false;
+		}
+		for (const auto& vertex : b) {
+			if (distanceToOutline(vertex, a) > tolerance)
+				return false;
+		}
+		return true;
+	}
+}
+
+SilhouetteEdges::SilhouetteEdges(float moveTolerance)
+	: m_moveTolerance(moveTolerance)
+{
+}
+
+int SilhouetteEdges::update(b2World* world, const std::vector<std::vector<glm::vec2>>& outlines, int count, glm::vec2 scale)
+{
+	for (auto& chain : m_chains)
+		chain.matched = false;
+
+	int rebuilt = 0;
+	for (int i = 0; i < count; i++) {
+		if (outlines[i].size() < 2)
+			continue;
+		m_scaled.clear();
+		for (const auto& vertex : outlines[i])
+			m_scaled.emplace_back(vertex.x * scale.x, vertex.y * scale.y);
+		const glm::vec2 centroid = getCentroid(m_scaled);
+
+		Chain* nearest = nullptr;
+		float nearestDistance = std::numeric_limits<float>::max();
+		for (auto& chain : m_chains) {
+			const float distance = glm::distance(chain.centroid, centroid);
+			if (!chain.matched && distance < nearestDistance) {
+				nearest = &chain;
+				nearestDistance = distance;
+			}
+		}
+		if (nearest && isSameOutline(nearest->vertices, m_scaled, m_moveTolerance)) {
+			nearest->matched = true;
+			continue;
+		}
+
+		if (!nearest) {
+			m_chains.emplace_back();
+			nearest = &m_chains.back();
+			nearest->edge = std::make_shared<ofxBox2dEdge>();
+		}
+		else {
+			nearest->edge->destroy();
+			nearest->edge->clear();
+		}
+		auto& edge = *nearest->edge;
+		for (const auto& vertex : m_scaled)
+			edge.addVertex(vertex.x, vertex.y);
+		edge.addVertex(m_scaled.front().x, m_scaled.front().y); // closed
+		edge.create(world);
+		nearest->vertices = m_scaled;
+		nearest->centroid = centroid;
+		nearest->matched = true;
+		rebuilt++;
+	}
+
+	// people that left
+	for (auto& chain : m_chains) {
+		if (!chain.matched)
+			chain.edge->destroy();
+	}
+	m_chains.erase(std::remove_if(m_chains.begin(), m_chains.end(), [](const Chain& chain) { return !chain.matched; }), m_chains.end());
+	return rebuilt;
+}
+
+void SilhouetteEdges::clear()
+{
+	for (auto& chain : m_chains)
+		chain.edge->destroy();
+	m_chains.clear();
+}
+
+void SilhouetteEdges::draw()
+{
+	for (auto& chain : m_chains)
+		chain.edge->draw();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxBox2d.h"
+
+// Static ofxBox2dEdge chains around closed outlines, kept in step with them
+// from frame to frame. Every outline is paired with the chain whose centroid
+// is closest; a chain is only rebuilt when its outline moved by more than
+// moveTolerance pixels, so still people cost Box2D nothing.
+class SilhouetteEdges
+{
+
+public:
+	explicit SilhouetteEdges(float moveTolerance);
+
+	// Takes the first count outlines, scaled by scale into window coordinates.
+	// Returns the number of chains rebuilt.
+	int update(b2World* world, const std::vector<std::vector<glm::vec2>>& outlines, int count, glm::vec2 scale);
+
+	// Removes every chain from the world.
+	void clear();
+
+	void draw();
+
+	int getNumChains() const { return int(m_chains.size()); }
+	// A chain's outline in window coordinates, the first vertex not repeated.
+	const std::vector<glm::vec2>& getOutline(int chain) const { return m_chains[chain].vertices; }
+
+private:
+	struct Chain
+	{
+		std::shared_ptr<ofxBox2dEdge> edge;
+		std::vector<glm::vec2> vertices; // closed, the first vertex not repeated
+		glm::vec2 centroid;
+		bool matched = false;
+	};
+
+	float m_moveTolerance;
+	std::vector<Chain> m_chains;
+	std::vector<glm::vec2> m_scaled;
+};
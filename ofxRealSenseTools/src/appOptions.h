@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdlib>
+#include <string>
+
+// Command line options shared by the apps:
+//   --source=<description>  depth source, see createDepthSource() (default: live)
+//   --headless              run update() without a window or GL context
+//   --frames=<n>            exit after n depth frames (0 = run until closed)
+//   --threads=<n>           threads for the parallel mesh build (0 = all cores)
+//   --record=<path>         record the depth frames to a depth recording (.rsdepth)
+struct AppOptions
+{
+	std::string depthSource = "live";
+	bool headless = false;
+	int frames = 0;
+	int threads = 0;
+	std::string record;
+
+	static AppOptions parse(int argc, char* argv[])
+	{
+		AppOptions options;
+		for (int i = 1; i < argc; i++) {
+			const std::string arg = argv[i];
+			if (arg.compare(0, 9, "--source=") == 0)
+				options.depthSource = arg.substr(9);
+			else if (arg == "--headless")
+				options.headless = true;
+			else if (arg.compare(0, 9, "--frames=") == 0)
+				options.frames = std::atoi(arg.c_str() + 9);
+			else if (arg.compare(0, 10, "--threads=") == 0)
+				options.threads = std::atoi(arg.c_str() + 10);
+			else if (arg.compare(0, 9, "--record=") == 0)
+				options.record = arg.substr(9);
+		}
+		return options;
+	}
+};
@@ -0,0 +1,116 @@
+#include "circleBatch.h"
+
+namespace {
+	const std::string vertexShader = R"(
+		#version 330
+		uniform mat4 modelViewProjectionMatrix;
+		in vec4 position; // on the unit circle
+		in vec3 circle;   // centre and radius
+		in vec4 circleColor;
+		out vec4 color;
+		void main() {
+			color = circleColor;
+			gl_Position = modelViewProjectionMatrix * vec4(circle.xy + position.xy * circle.z, 0.0, 1.0);
+		}
+	)";
+
+	const std::string fragmentShader = R"(
+		#version 330
+		in vec4 color;
+		out vec4 outputColor;
+		void main() {
+			outputColor = color;
+		}
+	)";
+}
+
+CircleBatch::CircleBatch(int segments)
+	: m_segments(std::max(3, segments))
+{
+}
+
+void CircleBatch::clear()
+{
+	m_circles.clear();
+	m_colors.clear();
+}
+
+void CircleBatch::add(const glm::vec2& centre, float radius, const ofFloatColor& color)
+{
+	m_circles.emplace_back(centre.x, centre.y, radius);
+	m_colors.push_back(color);
+}
+
+bool CircleBatch::growCapacity(const std::function<void(const glm::vec3*, const ofFloatColor*, int)>& allocate)
+{
+	const int count = size();
+	if (count <= m_capacity)
+		return false;
+	// grown in powers of two, so a slowly rising count doesn't reallocate every frame
+	m_capacity = std::max(64, m_capacity);
+	while (m_capacity < count)
+		m_capacity *= 2;
+	// padded out to the new capacity just for the allocating upload
+	m_circles.resize(m_capacity);
+	m_colors.resize(m_capacity);
+	allocate(m_circles.data(), m_colors.data(), m_capacity);
+	m_circles.resize(count);
+	m_colors.resize(count);
+	return true;
+}
+
+void CircleBatch::setup()
+{
+	// a fan around the centre, the first rim vertex repeated to close it
+	std::vector<glm::vec3> fan = { glm::vec3(0, 0, 0) };
+	for (int i = 0; i <= m_segments; i++) {
+		const float angle = TWO_PI * i / m_segments;
+		fan.emplace_back(std::cos(angle), std::sin(angle), 0);
+	}
+	m_vbo.setVertexData(fan.data(), int(fan.size()), GL_STATIC_DRAW);
+
+	m_shader.setupShaderFromSource(GL_VERTEX_SHADER, vertexShader);
+	m_shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragmentShader);
+	m_shader.bindDefaults();
+	m_shader.linkProgram();
+	m_circleLocation = m_shader.getAttributeLocation("circle");
+	m_colorLocation = m_shader.getAttributeLocation("circleColor");
+	m_isSetup = true;
+}
+
+void CircleBatch::draw()
+{
+	if (m_circles.empty())
+		return;
+	if (!m_isSetup)
+		setup();
+
+	const int count = size();
+	growCapacity([this](const glm::vec3* circles, const ofFloatColor* colors, int capacity) {
+		m_vbo.setAttributeData(m_circleLocation, &circles->x, 3, capacity, GL_DYNAMIC_DRAW);
+		m_vbo.setAttributeData(m_colorLocation, &colors->r, 4, capacity, GL_DYNAMIC_DRAW);
+		m_vbo.setAttributeDivisor(m_circleLocation, 1);
+		m_vbo.setAttributeDivisor(m_colorLocation, 1);
+	});
+	m_vbo.updateAttributeData(m_circleLocation, &m_circles[0].x, count);
+	m_vbo.updateAttributeData(m_colorLocation, &m_colors[0].r, count);
+
+	m_shader.begin();
+	m_vbo.drawInstanced(GL_TRIANGLE_FAN, 0, m_segments + 2, count);
+	m_shader.end();
+}
+
+//--------------------------------------------------------------
+void addInterpolatedCircles(CircleBatch& batch, const std::vector<CircleState>& previous,
+	const std::vector<CircleState>& current, float alpha, const ofFloatColor& color, const ofFloatColor& hitColor)
+{
+	for (size_t i = 0; i < current.size(); i++) {
+		const auto& body = current[i];
+		if (body.spawnOrder == 0)
+			continue;
+		glm::vec2 position = body.position;
+		if (i < previous.size() && previous[i].spawnOrder == body.spawnOrder)
+			position = previous[i].position + (body.position - previous[i].position) * alpha;
+		batch.add(position, body.radius, body.hit ? hitColor : color);
+	}
+}
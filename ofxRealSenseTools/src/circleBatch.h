@@ -0,0 +1,63 @@
+#pragma once
+#include "ofMain.h"
+#include <functional>
+
+// Filled 2D circles drawn with one instanced draw call. add() appends a
+// circle's centre, radius and colour to per-instance arrays on the CPU; draw()
+// uploads them into instance attributes (reusing the buffers while they fit)
+// and draws a unit circle once per instance with a small shader. Needs the
+// programmable renderer (GL 3.3).
+class CircleBatch
+{
+
+public:
+	explicit CircleBatch(int segments = 32);
+
+	void clear();
+	void add(const glm::vec2& centre, float radius, const ofFloatColor& color);
+
+	int size() const { return int(m_circles.size()); }
+	// per instance: x, y, radius
+	const std::vector<glm::vec3>& getCircles() const { return m_circles; }
+	const std::vector<ofFloatColor>& getColors() const { return m_colors; }
+
+	void draw();
+
+	// Instances the attribute buffers hold. When size() outgrows it, draw()
+	// calls growCapacity() to allocate bigger ones.
+	int getCapacity() const { return m_capacity; }
+	// Grows the capacity in powers of two until size() fits and calls allocate
+	// with the arrays padded out to it, then shrinks them back to size().
+	// Returns false, without calling allocate, when they already fit.
+	bool growCapacity(const std::function<void(const glm::vec3* circles, const ofFloatColor* colors, int capacity)>& allocate);
+
+private:
+	void setup();
+
+	int m_segments;
+	std::vector<glm::vec3> m_circles;
+	std::vector<ofFloatColor> m_colors;
+
+	ofVbo m_vbo;
+	ofShader m_shader;
+	int m_circleLocation = -1;
+	int m_colorLocation = -1;
+	int m_capacity = 0;
+	bool m_isSetup = false;
+};
+
+// A circle as a physics tick left it, per body slot.
+struct CircleState
+{
+	glm::vec2 position;
+	float radius = 0;
+	uint64_t spawnOrder = 0; // 0 for a parked slot
+	bool hit = false;
+};
+
+// Adds the live circles of current to batch, each alpha of the way from where
+// it was in previous (0 the previous tick, 1 the current one) when that slot
+// still held the same circle, so a respawned body doesn't streak across the
+// screen. Hit circles are drawn in hitColor.
+void addInterpolatedCircles(CircleBatch& batch, const std::vector<CircleState>& previous,
+	const std::vector<CircleState>& current, float alpha, const ofFloatColor& color, const ofFloatColor& hitColor);
@@ -0,0 +1,78 @@
+#include "depthCapture.h"
+
+namespace {
+	// Upper bound on one wait so the thread notices stop() promptly.
+	const unsigned int frameTimeoutMs = 1000;
+}
+
+DepthCapture::~DepthCapture()
+{
+	stop();
+}
+
+void DepthCapture::start(std::unique_ptr<DepthSource> source)
+{
+	if (m_started)
+		return;
+	m_source = source ? std::move(source) : std::make_unique<LiveDepthSource>();
+	m_source->start();
+	m_started = true;
+	startThread();
+}
+
+void DepthCapture::stop()
+{
+	if (!m_started)
+		return;
+	waitForThread(true);
+	m_source->stop();
+	m_started = false;
+}
+
+rs2::frame DepthCapture::getLatestFrame()
+{
+	if (!m_frames.fetch()) {
+		if (m_capturedFrames > 0)
+			m_duplicateFrames++;
+		return rs2::frame();
+	}
+	return m_frames.getReadBuffer();
+}
+
+std::string DepthCapture::getSourceDescription() const
+{
+	return m_source ? m_source->getDescription() : "none";
+}
+
+uint64_t DepthCapture::getCapturedFrames() const
+{
+	return m_capturedFrames;
+}
+
+uint64_t DepthCapture::getDroppedFrames() const
+{
+	return m_droppedFrames;
+}
+
+uint64_t DepthCapture::getDuplicateFrames() const
+{
+	return m_duplicateFrames;
+}
+
+void DepthCapture::threadedFunction()
+{
+	while (isThreadRunning()) {
+		rs2::frame depth;
+		{
+			ScopedStageTimer timer(m_profiler, StageProfiler::CaptureWait);
+			depth = m_source->waitForFrame(frameTimeoutMs);
+		}
+		if (!depth)
+			continue;
+
+		m_frames.getWriteBuffer() = depth;
+		if (m_frames.publish())
+			m_droppedFrames++;
+		m_capturedFrames++;
+	}
+}
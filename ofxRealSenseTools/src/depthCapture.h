@@ -0,0 +1,46 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include "ofMain.h"
+#include "depthSource.h"
+#include "stageProfiler.h"
+#include "tripleBuffer.h"
+
+// Owns the depth source and waits for frames on its own thread so that
+// ofApp::update() never blocks on the sensor. Frames are handed over through a
+// triple buffer: update() always gets the newest depth frame, and frames that
+// arrive faster than the app consumes them are dropped (and counted).
+class DepthCapture : public ofThread
+{
+
+public:
+	~DepthCapture();
+
+	// Starts capturing from source, or from the live camera if none is given.
+	void start(std::unique_ptr<DepthSource> source = nullptr);
+	void stop();
+
+	// Time spent waiting on the source is recorded as StageProfiler::CaptureWait.
+	// Set before start().
+	void setProfiler(StageProfiler* profiler) { m_profiler = profiler; }
+
+	// Non-blocking. Returns the newest depth frame published since the last
+	// call, or an empty frame if the sensor has not delivered a new one yet.
+	rs2::frame getLatestFrame();
+
+	std::string getSourceDescription() const;
+	uint64_t getCapturedFrames() const;
+	uint64_t getDroppedFrames() const;   // captured but never picked up by the app
+	uint64_t getDuplicateFrames() const; // app asked but no new frame was ready
+
+protected:
+	void threadedFunction() override;
+
+private:
+	std::unique_ptr<DepthSource> m_source;
+	StageProfiler* m_profiler = nullptr;
+	TripleBuffer<rs2::frame> m_frames;
+	std::atomic<uint64_t> m_capturedFrames{ 0 };
+	std::atomic<uint64_t> m_droppedFrames{ 0 };
+	std::atomic<uint64_t> m_duplicateFrames{ 0 };
+	bool m_started = false;
+};
@@ -0,0 +1,218 @@
+#include "depthContours.h"
+#include <algorithm>
+
+namespace {
+	// the 8 neighbours clockwise (y down) from the left one
+	const glm::ivec2 neighbours[8] = { { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 } };
+
+	int neighbourIndex(glm::ivec2 offset)
+	{
+		for (int i = 0; i < 8; i++) {
+			if (neighbours[i].x == offset.x && neighbours[i].y == offset.y)
+				return i;
+		}
+		return 0;
+	}
+
+	float distanceToSegment(glm::vec2 point, glm::vec2 a, glm::vec2 b)
+	{
+		const glm::vec2 ab = b - a;
+		const float lengthSquared = glm::dot(ab, ab);
+		const float t = lengthSquared > 0 ? ofClamp(glm::dot(point - a, ab) / lengthSquared, 0, 1) : 0;
+		return glm::length(point - (a + ab * t));
+	}
+}
+
+int DepthContours::update(const DepthView& depth, float depthUnits, const ContourSettings& settings)
+{
+	m_stepSize = std::max(1, settings.stepSize);
+	const int columns = (depth.width + m_stepSize - 1) / m_stepSize;
+	const int rows = (depth.height + m_stepSize - 1) / m_stepSize;
+	m_maskWidth = columns + 2;
+	m_maskHeight = rows + 2;
+
+	const float minRaw = std::max(1.0f, std::ceil(settings.minDistance / depthUnits));
+	const float maxRaw = std::floor(settings.maxDistance / depthUnits);
+	m_labels.assign(m_maskWidth * m_maskHeight, 0);
+	for (int y = 0; y < rows; y++) {
+		const uint16_t* depthRow = depth.row(y * m_stepSize);
+		int* labels = &m_labels[(y + 1) * m_maskWidth + 1];
+		for (int x = 0; x < columns; x++) {
+			const uint16_t raw = depthRow[x * m_stepSize];
+			labels[x] = raw >= minRaw && raw <= maxRaw ? -1 : 0;
+		}
+	}
+
+	m_blobs.clear();
+	for (int i = 0; i < int(m_labels.size()); i++) {
+		if (m_labels[i] == -1) {
+			const int label = int(m_blobs.size()) + 1;
+			m_blobs.push_back({ label, i, fillBlob(label, i) });
+		}
+	}
+	m_blobs.erase(std::remove_if(m_blobs.begin(), m_blobs.end(), [&](const Blob& blob) { return blob.area < settings.minArea; }), m_blobs.end());
+	std::sort(m_blobs.begin(), m_blobs.end(), [](const Blob& a, const Blob& b) { return a.area > b.area; });
+
+	// at least a triangle per contour
+	m_numContours = std::min({ int(m_blobs.size()), settings.maxContours, settings.vertexBudget / 3 });
+	if (int(m_boundaries.size()) < m_numContours) {
+		m_boundaries.resize(m_numContours);
+		m_keep.resize(m_numContours);
+		m_contours.resize(m_numContours);
+	}
+	for (int i = 0; i < m_numContours; i++)
+		traceBoundary(m_blobs[i].label, m_blobs[i].start, m_boundaries[i]);
+
+	simplify(settings);
+	return m_numContours;
+}
+
+int DepthContours::fillBlob(int label, int start)
+{
+	m_queue.clear();
+	m_queue.push_back(start);
+	m_labels[start] = label;
+	// the border keeps every neighbour of a foreground pixel inside the mask
+	for (size_t i = 0; i < m_queue.size(); i++) {
+		const int index = m_queue[i];
+		for (const auto& offset : neighbours) {
+			const int neighbour = index + offset.y * m_maskWidth + offset.x;
+			if (m_labels[neighbour] == -1) {
+				m_labels[neighbour] = label;
+				m_queue.push_back(neighbour);
+			}
+		}
+	}
+	return int(m_queue.size());
+}
+
+void DepthContours::traceBoundary(int label, int start, std::vector<glm::ivec2>& boundary)
+{
+	// Moore neighbour tracing. The start is the blob's first pixel in raster
+	// order, so its left and upper neighbours are outside the blob.
+	const glm::ivec2 first(start % m_maskWidth, start / m_maskWidth);
+	auto inBlob = [&](glm::ivec2 p) { return m_labels[p.y * m_maskWidth + p.x] == label; };
+
+	boundary.clear();
+	boundary.push_back(first);
+	glm::ivec2 pixel = first;
+	int backtrack = 0; // towards the outside pixel the search around pixel starts after
+	int firstMove = -1;
+	const int maxSteps = 4 * m_maskWidth * m_maskHeight;
+	for (int step = 0; step < maxSteps; step++) {
+		int move = -1;
+		for (int k = 1; k <= 8; k++) {
+			const int direction = (backtrack + k) % 8;
+			if (inBlob(pixel + neighbours[direction])) {
+				move = direction;
+				break;
+			}
+		}
+		if (move < 0)
+			break; // a single pixel
+		// back at the start and about to go round the same way again
+		if (pixel == first && move == firstMove)
+			break;
+		if (firstMove < 0)
+			firstMove = move;
+
+		const glm::ivec2 next = pixel + neighbours[move];
+		const glm::ivec2 outside = pixel + neighbours[(move + 7) % 8];
+		backtrack = neighbourIndex(outside - next);
+		pixel = next;
+		boundary.push_back(pixel);
+	}
+	if (boundary.size() > 1 && boundary.back() == first)
+		boundary.pop_back();
+}
+
+DepthContours::Segment DepthContours::findSplit(int contour, int first, int last) const
+{
+	const auto& points = m_boundaries[contour];
+	const int count = int(points.size());
+	const glm::vec2 a(points[first]);
+	const glm::vec2 b(points[last % count]);
+	Segment segment{ -1, contour, first, last, -1 };
+	for (int i = first + 1; i < last; i++) {
+		const float error = distanceToSegment(glm::vec2(points[i]), a, b);
+		if (error > segment.error) {
+			segment.error = error;
+			segment.split = i;
+		}
+	}
+	return segment;
+}
+
+void DepthContours::simplify(const ContourSettings& settings)
+{
+	m_heap.clear();
+	m_numVertices = 0;
+	auto push = [this](const Segment& segment) {
+		if (segment.split < 0)
+			return;
+		m_heap.push_back(segment);
+		std::push_heap(m_heap.begin(), m_heap.end());
+	};
+
+	// every closed contour starts as a triangle: its first point, the point
+	// furthest from it, and the worst point of the two halves between them
+	for (int c = 0; c < m_numContours; c++) {
+		const auto& points = m_boundaries[c];
+		const int count = int(points.size());
+		m_keep[c].assign(count, 0);
+		if (count <= 3) {
+			std::fill(m_keep[c].begin(), m_keep[c].end(), 1);
+			m_numVertices += count;
+			continue;
+		}
+
+		int furthest = 0;
+		int furthestDistance = 0;
+		for (int i = 1; i < count; i++) {
+			const glm::ivec2 offset = points[i] - points[0];
+			const int distance = offset.x * offset.x + offset.y * offset.y;
+			if (distance > furthestDistance) {
+				furthestDistance = distance;
+				furthest = i;
+			}
+		}
+		m_keep[c][0] = 1;
+		m_keep[c][furthest] = 1;
+		m_numVertices += 2;
+
+		Segment halves[2] = { findSplit(c, 0, furthest), findSplit(c, furthest, count) };
+		const int worse = halves[1].error > halves[0].error ? 1 : 0;
+		const Segment& split = halves[worse];
+		if (split.split >= 0) {
+			m_keep[c][split.split] = 1;
+			m_numVertices++;
+			push(findSplit(c, split.first, split.split));
+			push(findSplit(c, split.split, split.last));
+		}
+		push(halves[1 - worse]);
+	}
+
+	// then the worst segment over all contours, until the budget is spent or
+	// every segment is within tolerance
+	while (!m_heap.empty() && m_numVertices < settings.vertexBudget) {
+		std::pop_heap(m_heap.begin(), m_heap.end());
+		const Segment segment = m_heap.back();
+		m_heap.pop_back();
+		if (segment.error <= settings.tolerance)
+			break;
+		m_keep[segment.contour][segment.split] = 1;
+		m_numVertices++;
+		push(findSplit(segment.contour, segment.first, segment.split));
+		push(findSplit(segment.contour, segment.split, segment.last));
+	}
+
+	for (int c = 0; c < m_numContours; c++) {
+		const auto& points = m_boundaries[c];
+		auto& contour = m_contours[c];
+		contour.clear();
+		for (int i = 0; i < int(points.size()); i++) {
+			if (m_keep[c][i])
+				contour.emplace_back((points[i].x - 1) * m_stepSize, (points[i].y - 1) * m_stepSize);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "ofMain.h"
+#include "depthView.h"
+
+struct ContourSettings
+{
+	float minDistance = 0.3f; // metres, samples from minDistance to maxDistance are foreground
+	float maxDistance = 1.5f;
+	int stepSize = 4; // the mask samples every stepSize-th pixel
+	int minArea = 40; // mask pixels, smaller blobs are noise
+	int maxContours = 8; // largest blobs first
+	int vertexBudget = 160; // over all contours together
+	float tolerance = 0.75f; // mask pixels: segments closer than this aren't split further
+};
+
+// Outlines of the foreground blobs of a depth frame. update() thresholds a
+// subsampled mask, labels its 8-connected blobs, traces the outer boundary of
+// the largest ones and simplifies them with Douglas-Peucker. Splits are made
+// in order of error over all contours at once, so the vertex budget goes where
+// it matters most. Every buffer is reused from frame to frame.
+class DepthContours
+{
+
+public:
+	// Returns the number of contours.
+	int update(const DepthView& depth, float depthUnits, const ContourSettings& settings);
+
+	// Closed outlines in depth frame pixels, the first vertex not repeated,
+	// largest blob first. Only the first getNumContours() are valid.
+	const std::vector<std::vector<glm::vec2>>& getContours() const { return m_contours; }
+	int getNumContours() const { return m_numContours; }
+	int getNumVertices() const { return m_numVertices; }
+
+private:
+	struct Blob
+	{
+		int label;
+		int start; // first mask index in raster order
+		int area;
+	};
+	struct Segment
+	{
+		float error;
+		int contour;
+		int first; // point indices, last may be the contour size for the closing segment
+		int last;
+		int split;
+		bool operator<(const Segment& other) const { return error < other.error; }
+	};
+
+	int fillBlob(int label, int start);
+	void traceBoundary(int label, int start, std::vector<glm::ivec2>& boundary);
+	Segment findSplit(int contour, int first, int last) const;
+	void simplify(const ContourSettings& settings);
+
+	int m_maskWidth = 0; // with a one pixel border of background
+	int m_maskHeight = 0;
+	std::vector<int> m_labels; // 0 background, -1 unlabelled foreground, blob index + 1
+	std::vector<int> m_queue;
+	std::vector<Blob> m_blobs;
+	std::vector<std::vector<glm::ivec2>> m_boundaries;
+	std::vector<std::vector<uint8_t>> m_keep;
+	std::vector<Segment> m_heap;
+	std::vector<std::vector<glm::vec2>> m_contours;
+	int m_numContours = 0;
+	int m_numVertices = 0;
+	int m_stepSize = 1;
+};
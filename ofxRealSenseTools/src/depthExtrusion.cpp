@@ -0,0 +1,247 @@
+#include "depthExtrusion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DEPTH_EXTRUSION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSE4.1/AVX2 instructions in functions that ask for
+// them, so the rest of the addon keeps building for the baseline CPU.
+#if defined(__GNUC__)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+// The maths below must stay exactly ofMap()'s: subtract, divide, multiply, add,
+// each rounded to float. In particular no fused multiply-add, which rounds once
+// instead of twice and would no longer match the scalar path bit for bit.
+
+namespace {
+	struct Mapping
+	{
+		float depthUnits;
+		float inputMin;
+		float inputRange;
+		float outputRange;
+		float outputMin;
+		float clampLow;
+		float clampHigh;
+		bool clamp;
+		float minValid;
+		float maxValid;
+		bool exclusiveRange;
+	};
+
+	Mapping makeMapping(const DepthExtrusion& extrusion)
+	{
+		Mapping mapping;
+		mapping.depthUnits = extrusion.depthUnits;
+		mapping.inputMin = extrusion.minRawDepth;
+		mapping.inputRange = extrusion.maxRawDepth - extrusion.minRawDepth;
+		mapping.outputRange = extrusion.maxMappedDepth - extrusion.minMappedDepth;
+		mapping.outputMin = extrusion.minMappedDepth;
+		mapping.clampLow = std::min(extrusion.minMappedDepth, extrusion.maxMappedDepth);
+		mapping.clampHigh = std::max(extrusion.minMappedDepth, extrusion.maxMappedDepth);
+		mapping.clamp = extrusion.clamp;
+		mapping.minValid = extrusion.minMappedDepth;
+		mapping.maxValid = extrusion.maxMappedDepth;
+		mapping.exclusiveRange = extrusion.exclusiveRange;
+		return mapping;
+	}
+
+	bool isValid(float z, const Mapping& m)
+	{
+		return m.exclusiveRange ? (z > m.minValid && z < m.maxValid) : (z >= m.minValid && z <= m.maxValid);
+	}
+
+	void extrudeScalar(const uint16_t* raw, int first, int count, int step, const Mapping& m, float* z, uint8_t* valid)
+	{
+		for (int i = first; i < count; i++) {
+			const float distance = raw[i * step] * m.depthUnits;
+			float value = (distance - m.inputMin) / m.inputRange * m.outputRange + m.outputMin;
+			if (m.clamp) {
+				// ofMap() clamps to whichever of min/maxMappedDepth is the upper bound
+				if (value > m.clampHigh)
+					value = m.clampHigh;
+				else if (value < m.clampLow)
+					value = m.clampLow;
+			}
+			z[i] = value;
+			if (valid)
+				valid[i] = isValid(value, m);
+		}
+	}
+
+#ifdef DEPTH_EXTRUSION_X86
+	TARGET_SSE41
+	void extrudeSse41(const uint16_t* raw, int count, int step, const Mapping& m, float* z, uint8_t* valid)
+	{
+		const __m128 depthUnits = _mm_set1_ps(m.depthUnits);
+		const __m128 inputMin = _mm_set1_ps(m.inputMin);
+		const __m128 inputRange = _mm_set1_ps(m.inputRange);
+		const __m128 outputRange = _mm_set1_ps(m.outputRange);
+		const __m128 outputMin = _mm_set1_ps(m.outputMin);
+		const __m128 clampLow = _mm_set1_ps(m.clampLow);
+		const __m128 clampHigh = _mm_set1_ps(m.clampHigh);
+		const __m128 minValid = _mm_set1_ps(m.minValid);
+		const __m128 maxValid = _mm_set1_ps(m.maxValid);
+		const __m128i one = _mm_set1_epi32(1);
+
+		int i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128i samples;
+			if (step == 1)
+				samples = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(raw + i)));
+			else
+				samples = _mm_setr_epi32(raw[i * step], raw[(i + 1) * step], raw[(i + 2) * step], raw[(i + 3) * step]);
+
+			const __m128 distance = _mm_mul_ps(_mm_cvtepi32_ps(samples), depthUnits);
+			__m128 value = _mm_add_ps(_mm_mul_ps(_mm_div_ps(_mm_sub_ps(distance, inputMin), inputRange), outputRange), outputMin);
+			if (m.clamp)
+				value = _mm_min_ps(_mm_max_ps(value, clampLow), clampHigh);
+			_mm_storeu_ps(z + i, value);
+
+			if (valid) {
+				const __m128 inRange = m.exclusiveRange ?
+					_mm_and_ps(_mm_cmpgt_ps(value, minValid), _mm_cmplt_ps(value, maxValid)) :
+					_mm_and_ps(_mm_cmpge_ps(value, minValid), _mm_cmple_ps(value, maxValid));
+				__m128i flags = _mm_and_si128(_mm_castps_si128(inRange), one);
+				flags = _mm_packus_epi16(_mm_packs_epi32(flags, flags), flags);
+				const int32_t packed = _mm_cvtsi128_si32(flags);
+				std::memcpy(valid + i, &packed, 4);
+			}
+		}
+		extrudeScalar(raw, i, count, step, m, z, valid);
+	}
+
+	TARGET_AVX2
+	void extrudeAvx2(const uint16_t* raw, int count, int step, const Mapping& m, float* z, uint8_t* valid)
+	{
+		const __m256 depthUnits = _mm256_set1_ps(m.depthUnits);
+		const __m256 inputMin = _mm256_set1_ps(m.inputMin);
+		const __m256 inputRange = _mm256_set1_ps(m.inputRange);
+		const __m256 outputRange = _mm256_set1_ps(m.outputRange);
+		const __m256 outputMin = _mm256_set1_ps(m.outputMin);
+		const __m256 clampLow = _mm256_set1_ps(m.clampLow);
+		const __m256 clampHigh = _mm256_set1_ps(m.clampHigh);
+		const __m256 minValid = _mm256_set1_ps(m.minValid);
+		const __m256 maxValid = _mm256_set1_ps(m.maxValid);
+		const __m256i one = _mm256_set1_epi32(1);
+
+		int i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256i samples;
+			if (step == 1)
+				samples = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i)));
+			else
+				samples = _mm256_setr_epi32(raw[i * step], raw[(i + 1) * step], raw[(i + 2) * step], raw[(i + 3) * step],
+					raw[(i + 4) * step], raw[(i + 5) * step], raw[(i + 6) * step], raw[(i + 7) * step]);
+
+			const __m256 distance = _mm256_mul_ps(_mm256_cvtepi32_ps(samples), depthUnits);
+			__m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(distance, inputMin), inputRange), outputRange), outputMin);
+			if (m.clamp)
+				value = _mm256_min_ps(_mm256_max_ps(value, clampLow), clampHigh);
+			_mm256_storeu_ps(z + i, value);
+
+			if (valid) {
+				const __m256 inRange = m.exclusiveRange ?
+					_mm256_and_ps(_mm256_cmp_ps(value, minValid, _CMP_GT_OQ), _mm256_cmp_ps(value, maxValid, _CMP_LT_OQ)) :
+					_mm256_and_ps(_mm256_cmp_ps(value, minValid, _CMP_GE_OQ), _mm256_cmp_ps(value, maxValid, _CMP_LE_OQ));
+				const __m256i flags = _mm256_and_si256(_mm256_castps_si256(inRange), one);
+				const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(flags), _mm256_extracti128_si256(flags, 1));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(valid + i), _mm_packus_epi16(words, words));
+			}
+		}
+		extrudeScalar(raw, i, count, step, m, z, valid);
+	}
+
+	bool cpuSupportsSse41()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 19)) != 0;
+#else
+		return __builtin_cpu_supports("sse4.1");
+#endif
+	}
+
+	bool cpuSupportsAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		if (!osSavesAvx)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+SimdPath getSupportedSimdPath()
+{
+	static const SimdPath supported = []() {
+#ifdef DEPTH_EXTRUSION_X86
+		if (cpuSupportsAvx2())
+			return SimdPath::Avx2;
+		if (cpuSupportsSse41())
+			return SimdPath::Sse41;
+#endif
+		return SimdPath::Scalar;
+	}();
+	return supported;
+}
+
+const char* getSimdPathName(SimdPath path)
+{
+	switch (path) {
+	case SimdPath::Avx2: return "avx2";
+	case SimdPath::Sse41: return "sse4.1";
+	default: return "scalar";
+	}
+}
+
+void extrudeDepthRow(const uint16_t* raw, int count, int step, const DepthExtrusion& extrusion,
+	float* z, uint8_t* valid, SimdPath path)
+{
+	const Mapping mapping = makeMapping(extrusion);
+
+	// ofMap() returns minMappedDepth for an empty input range, without clamping
+	if (std::abs(mapping.inputRange) < std::numeric_limits<float>::epsilon()) {
+		std::fill(z, z + count, mapping.outputMin);
+		if (valid)
+			std::fill(valid, valid + count, uint8_t(isValid(mapping.outputMin, mapping)));
+		return;
+	}
+
+	path = std::min(path, getSupportedSimdPath());
+#ifdef DEPTH_EXTRUSION_X86
+	if (path == SimdPath::Avx2) {
+		extrudeAvx2(raw, count, step, mapping, z, valid);
+		return;
+	}
+	if (path == SimdPath::Sse41) {
+		extrudeSse41(raw, count, step, mapping, z, valid);
+		return;
+	}
+#endif
+	extrudeScalar(raw, 0, count, step, mapping, z, valid);
+}
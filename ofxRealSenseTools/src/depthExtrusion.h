@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+// How raw Z16 samples become extruded z values:
+//   z = ofMap(raw * depthUnits, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, clamp)
+// with the same float maths as depth_frame::get_distance() followed by ofMap().
+struct DepthExtrusion
+{
+	float depthUnits = 0.001f;
+	float minRawDepth = 0.1f;
+	float maxRawDepth = 2.0f;
+	float minMappedDepth = 1;
+	float maxMappedDepth = 1000;
+	bool clamp = false;
+	// A sample is valid when minMappedDepth <= z <= maxMappedDepth, or with
+	// exclusiveRange when minMappedDepth < z < maxMappedDepth. PointCloud uses the
+	// latter to drop the samples clamp pinned to either end of the range.
+	bool exclusiveRange = false;
+};
+
+// Instruction set extrudeDepthRow() runs on. Every path gives bit for bit the
+// same result as Scalar.
+enum class SimdPath { Scalar, Sse41, Avx2 };
+
+// Best path this CPU supports, detected once.
+SimdPath getSupportedSimdPath();
+const char* getSimdPathName(SimdPath path);
+
+// Converts count samples raw[0], raw[step], raw[2 * step] .. into extruded z
+// values and, if valid is not null, 1/0 validity flags. Runs on path, or on the
+// best supported path below it.
+void extrudeDepthRow(const uint16_t* raw, int count, int step, const DepthExtrusion& extrusion,
+	float* z, uint8_t* valid, SimdPath path);
+
+inline void extrudeDepthRow(const uint16_t* raw, int count, int step, const DepthExtrusion& extrusion,
+	float* z, uint8_t* valid)
+{
+	extrudeDepthRow(raw, count, step, extrusion, z, valid, getSupportedSimdPath());
+}
@@ -0,0 +1,27 @@
+#include "depthLut.h"
+#include "ofMain.h"
+
+bool DepthLut::update(float depthUnits, float minRawDepth, float maxRawDepth, float minMappedDepth, float maxMappedDepth, bool clamp)
+{
+	if (!m_table.empty() &&
+		depthUnits == m_depthUnits &&
+		minRawDepth == m_minRawDepth && maxRawDepth == m_maxRawDepth &&
+		minMappedDepth == m_minMappedDepth && maxMappedDepth == m_maxMappedDepth &&
+		clamp == m_clamp)
+		return false;
+
+	m_depthUnits = depthUnits;
+	m_minRawDepth = minRawDepth;
+	m_maxRawDepth = maxRawDepth;
+	m_minMappedDepth = minMappedDepth;
+	m_maxMappedDepth = maxMappedDepth;
+	m_clamp = clamp;
+
+	m_table.resize(65536);
+	for (int raw = 0; raw < 65536; raw++) {
+		// same float maths as depth_frame::get_distance() followed by ofMap()
+		const float distance = raw * depthUnits;
+		m_table[raw] = ofMap(distance, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, clamp);
+	}
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 65536 entry table from a raw Z16 sample straight to the extruded z value,
+// i.e. ofMap(raw * depthUnits, minRawDepth, maxRawDepth, minMappedDepth, maxMappedDepth, clamp).
+// The table is only rebuilt when one of those parameters changes.
+class DepthLut
+{
+
+public:
+	// Returns true if the table had to be rebuilt.
+	bool update(float depthUnits, float minRawDepth, float maxRawDepth, float minMappedDepth, float maxMappedDepth, bool clamp);
+
+	float operator[](uint16_t raw) const { return m_table[raw]; }
+	const float* data() const { return m_table.data(); }
+
+private:
+	std::vector<float> m_table;
+	float m_depthUnits = 0;
+	float m_minRawDepth = 0;
+	float m_maxRawDepth = 0;
+	float m_minMappedDepth = 0;
+	float m_maxMappedDepth = 0;
+	bool m_clamp = false;
+};
@@ -0,0 +1,171 @@
+#include "depthPooling.h"
+#include <algorithm>
+
+// SSE2 is part of every x86-64 CPU, so unlike depthExtrusion.cpp this needs no
+// runtime dispatch.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEPTH_POOLING_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+	// Per thread, so parallel block rows don't share it, and only ever grown.
+	struct PoolingScratch
+	{
+		std::vector<uint16_t> minimum;
+		std::vector<uint32_t> sum;
+		std::vector<uint16_t> validCount;
+		std::vector<uint16_t> values;
+		std::vector<int> valueCount;
+	};
+
+	// minimum[x] = min(minimum[x], row[x] - 1): an invalid 0 wraps round to
+	// 0xffff and so never wins over a valid sample.
+	void accumulateMinimum(const uint16_t* row, uint16_t* minimum, int count)
+	{
+		int x = 0;
+#ifdef DEPTH_POOLING_SSE2
+		const __m128i one = _mm_set1_epi16(1);
+		for (; x + 8 <= count; x += 8) {
+			const __m128i value = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), one);
+			const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(minimum + x));
+			// unsigned min without SSE4.1: a - saturate(a - b)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(minimum + x), _mm_sub_epi16(current, _mm_subs_epu16(current, value)));
+		}
+#endif
+		for (; x < count; x++)
+			minimum[x] = std::min(minimum[x], uint16_t(row[x] - 1));
+	}
+
+	// sum[x] += row[x] and validCount[x] += row[x] != 0
+	void accumulateSum(const uint16_t* row, uint32_t* sum, uint16_t* validCount, int count)
+	{
+		int x = 0;
+#ifdef DEPTH_POOLING_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		for (; x + 8 <= count; x += 8) {
+			const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			__m128i* sumLow = reinterpret_cast<__m128i*>(sum + x);
+			__m128i* sumHigh = reinterpret_cast<__m128i*>(sum + x + 4);
+			_mm_storeu_si128(sumLow, _mm_add_epi32(_mm_loadu_si128(sumLow), _mm_unpacklo_epi16(value, zero)));
+			_mm_storeu_si128(sumHigh, _mm_add_epi32(_mm_loadu_si128(sumHigh), _mm_unpackhi_epi16(value, zero)));
+
+			// 1 + (-1 where the sample is 0)
+			const __m128i valid = _mm_add_epi16(one, _mm_cmpeq_epi16(value, zero));
+			__m128i* counts = reinterpret_cast<__m128i*>(validCount + x);
+			_mm_storeu_si128(counts, _mm_add_epi16(_mm_loadu_si128(counts), valid));
+		}
+#endif
+		for (; x < count; x++) {
+			sum[x] += row[x];
+			validCount[x] += row[x] != 0;
+		}
+	}
+
+	void poolBlockRow(const DepthView& depth, const DepthSampling& sampling, DepthPooling mode, int row, uint16_t* pooled)
+	{
+		const int columns = sampling.getColumns();
+		const int step = sampling.stepSize;
+		const int firstX = sampling.border;
+		const int span = sampling.width - 2 * sampling.border; // pixels across all blocks of the row
+		const int firstY = sampling.border + row * step;
+		const int endY = std::min(sampling.height - sampling.border, firstY + step);
+		// block column of every pixel of the span is x / step
+		auto blockEnd = [&](int column) { return std::min(span, (column + 1) * step); };
+
+		thread_local PoolingScratch scratch;
+		switch (mode) {
+		case DepthPooling::Point:
+			for (int column = 0; column < columns; column++)
+				pooled[column] = depth.row(firstY)[firstX + column * step];
+			break;
+
+		case DepthPooling::Min: {
+			// rows first, a whole pixel row at a time, then across each block
+			scratch.minimum.assign(span, 0xffff);
+			for (int y = firstY; y < endY; y++)
+				accumulateMinimum(depth.row(y) + firstX, scratch.minimum.data(), span);
+			for (int column = 0; column < columns; column++) {
+				const auto first = scratch.minimum.begin() + column * step;
+				pooled[column] = uint16_t(*std::min_element(first, scratch.minimum.begin() + blockEnd(column)) + 1);
+			}
+			break;
+		}
+
+		case DepthPooling::Mean: {
+			scratch.sum.assign(span, 0);
+			scratch.validCount.assign(span, 0);
+			for (int y = firstY; y < endY; y++)
+				accumulateSum(depth.row(y) + firstX, scratch.sum.data(), scratch.validCount.data(), span);
+			for (int column = 0; column < columns; column++) {
+				uint64_t sum = 0;
+				uint32_t validCount = 0;
+				for (int x = column * step; x < blockEnd(column); x++) {
+					sum += scratch.sum[x];
+					validCount += scratch.validCount[x];
+				}
+				// rounded to the nearest raw unit
+				pooled[column] = validCount > 0 ? uint16_t((sum + validCount / 2) / validCount) : 0;
+			}
+			break;
+		}
+
+		case DepthPooling::Median: {
+			// gather each block's valid samples while streaming over the rows,
+			// then select the middle one (the lower of two, so it's a real sample)
+			const int capacity = step * step;
+			if (int(scratch.values.size()) < columns * capacity)
+				scratch.values.resize(columns * capacity);
+			scratch.valueCount.assign(columns, 0);
+			for (int y = firstY; y < endY; y++) {
+				const uint16_t* depthRow = depth.row(y) + firstX;
+				for (int column = 0; column < columns; column++) {
+					uint16_t* values = &scratch.values[column * capacity];
+					int& count = scratch.valueCount[column];
+					for (int x = column * step; x < blockEnd(column); x++) {
+						if (depthRow[x])
+							values[count++] = depthRow[x];
+					}
+				}
+			}
+			for (int column = 0; column < columns; column++) {
+				const int count = scratch.valueCount[column];
+				uint16_t* values = &scratch.values[column * capacity];
+				if (count == 0) {
+					pooled[column] = 0;
+					continue;
+				}
+				std::nth_element(values, values + (count - 1) / 2, values + count);
+				pooled[column] = values[(count - 1) / 2];
+			}
+			break;
+		}
+		}
+	}
+}
+
+const char* getDepthPoolingName(DepthPooling mode)
+{
+	switch (mode) {
+	case DepthPooling::Min: return "min";
+	case DepthPooling::Median: return "median";
+	case DepthPooling::Mean: return "mean";
+	default: return "point";
+	}
+}
+
+void poolDepthBlocks(const DepthView& depth, const DepthSampling& sampling, DepthPooling mode,
+	uint16_t* pooled, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	const int rows = sampling.getRows();
+	if (!pool) {
+		for (int row = 0; row < rows; row++)
+			poolBlockRow(depth, sampling, mode, row, pooled + row * columns);
+		return;
+	}
+	pool->parallelFor(rows, [&](int row) {
+		poolBlockRow(depth, sampling, mode, row, pooled + row * columns);
+	});
+}
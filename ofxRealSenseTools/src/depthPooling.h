@@ -0,0 +1,21 @@
+#pragma once
+#include "depthView.h"
+#include "meshKernels.h"
+
+// How a stepSize x stepSize block of the depth frame becomes one sample.
+// Point reads the block's top left pixel, like the apps always did; the
+// others only look at the block's valid (non-zero) pixels, so dropouts and
+// single noisy pixels don't alias into the mesh.
+enum class DepthPooling { Point, Min, Median, Mean };
+
+const char* getDepthPoolingName(DepthPooling mode);
+
+// Reduces the block of every sample of sampling (the stepSize x stepSize
+// pixels from the sample point right and down, cut off at the border) to one
+// raw value in pooled, sampling.getColumns() x getRows() values row after row.
+// A block without valid pixels becomes 0. Streams over the frame a block row
+// at a time with the row reductions vectorised; with a pool, block rows are
+// pooled in parallel. Read pooled through DepthView::fromSamples() with
+// DepthSampling::preSampled set.
+void poolDepthBlocks(const DepthView& depth, const DepthSampling& sampling, DepthPooling mode,
+	uint16_t* pooled, WorkerPool* pool = nullptr);
@@ -0,0 +1,172 @@
+#include "depthRecorder.h"
+#include "depthView.h"
+#include <cstring>
+
+using namespace DepthRecordingFormat;
+
+DepthRecorder::DepthRecorder(int keyframeInterval, int numBuffers)
+	: m_keyframeInterval(std::max(1, keyframeInterval))
+	, m_buffers(std::max(1, numBuffers))
+	, m_free(m_buffers.size())
+	, m_filled(m_buffers.size())
+{
+}
+
+DepthRecorder::~DepthRecorder()
+{
+	stop();
+}
+
+bool DepthRecorder::start(const std::string& path)
+{
+	if (m_recording)
+		return false;
+	m_file = std::fopen(ofToDataPath(path, true).c_str(), "wb");
+	if (!m_file) {
+		ofLogError("DepthRecorder") << "can't write " << path;
+		return false;
+	}
+	m_path = path;
+	m_width = 0;
+	m_height = 0;
+	m_failed = false;
+	m_offset = 0;
+	m_keyframes.clear();
+	m_recordedFrames = 0;
+	m_droppedFrames = 0;
+	m_bytesWritten = 0;
+
+	int index;
+	while (m_free.pop(index)) {}
+	for (int i = 0; i < int(m_buffers.size()); i++)
+		m_free.push(i);
+
+	m_recording = true;
+	startThread();
+	return true;
+}
+
+void DepthRecorder::stop()
+{
+	if (!m_recording)
+		return;
+	m_recording = false;
+	waitForThread(true); // the writer drains the queue before it returns
+}
+
+void DepthRecorder::add(const rs2::depth_frame& depth)
+{
+	if (!m_recording)
+		return;
+	const auto view = DepthView::fromFrame(depth);
+	if (m_width == 0) {
+		// the writer only reads these after it popped this frame
+		m_width = view.width;
+		m_height = view.height;
+		m_depthUnits = depth.get_units();
+	}
+
+	int index;
+	if (view.width != m_width || view.height != m_height || !m_free.pop(index)) {
+		m_droppedFrames++;
+		return;
+	}
+	auto& buffer = m_buffers[index];
+	buffer.pixels.resize(size_t(m_width) * m_height);
+	for (int y = 0; y < m_height; y++)
+		std::memcpy(&buffer.pixels[size_t(y) * m_width], view.row(y), m_width * sizeof(uint16_t));
+	buffer.timestampMs = depth.get_timestamp();
+	m_filled.push(index);
+}
+
+float DepthRecorder::getCompressionRatio() const
+{
+	const uint64_t written = m_bytesWritten;
+	return written > 0 ? float(double(m_recordedFrames) * m_width * m_height * sizeof(uint16_t) / written) : 0;
+}
+
+std::string DepthRecorder::getSummary() const
+{
+	if (!m_recording)
+		return "off";
+	return m_path + ", " + ofToString(getRecordedFrames()) + " frames at " + ofToString(getCompressionRatio(), 1)
+		+ ":1, " + ofToString(getDroppedFrames()) + " dropped";
+}
+
+void DepthRecorder::threadedFunction()
+{
+	int index;
+	while (isThreadRunning()) {
+		if (!m_filled.pop(index)) {
+			sleep(2);
+			continue;
+		}
+		write(m_buffers[index]);
+		m_free.push(index);
+	}
+	// stop() was called, no more frames come in
+	while (m_filled.pop(index)) {
+		write(m_buffers[index]);
+		m_free.push(index);
+	}
+	finish();
+}
+
+void DepthRecorder::write(Buffer& buffer)
+{
+	if (m_failed)
+		return;
+	if (m_offset == 0) {
+		Header header = {};
+		std::memcpy(header.magic, magic, sizeof(magic));
+		header.width = m_width;
+		header.height = m_height;
+		header.depthUnits = m_depthUnits;
+		header.keyframeInterval = m_keyframeInterval;
+		writeBytes(&header, sizeof(header));
+	}
+
+	const uint64_t frame = m_recordedFrames;
+	const bool keyframe = frame % m_keyframeInterval == 0;
+	m_payload.clear();
+	encodeFrame(buffer.pixels.data(), keyframe ? nullptr : m_previous.data(), m_width, m_height, m_payload);
+	if (keyframe)
+		m_keyframes.push_back(Keyframe{ frame, m_offset });
+
+	FrameHeader header;
+	header.flags = keyframe ? keyframeFlag : 0;
+	header.payloadSize = uint32_t(m_payload.size());
+	header.timestampMs = buffer.timestampMs;
+	if (writeBytes(&header, sizeof(header)) && writeBytes(m_payload.data(), m_payload.size()))
+		m_recordedFrames++;
+	// the next frame is coded against this one; the buffer gets overwritten anyway
+	m_previous.swap(buffer.pixels);
+}
+
+bool DepthRecorder::writeBytes(const void* data, size_t size)
+{
+	if (m_failed || std::fwrite(data, 1, size, m_file) != size) {
+		if (!m_failed)
+			ofLogError("DepthRecorder") << "can't write to " << m_path << ", recording stopped";
+		m_failed = true;
+		return false;
+	}
+	m_offset += size;
+	m_bytesWritten += size;
+	return true;
+}
+
+void DepthRecorder::finish()
+{
+	if (m_offset > 0) {
+		Trailer trailer = {};
+		trailer.keyframesOffset = m_offset;
+		trailer.numKeyframes = uint32_t(m_keyframes.size());
+		trailer.numFrames = uint32_t(m_recordedFrames);
+		std::memcpy(trailer.magic, indexMagic, sizeof(indexMagic));
+		writeBytes(m_keyframes.data(), m_keyframes.size() * sizeof(Keyframe));
+		writeBytes(&trailer, sizeof(trailer));
+	}
+	std::fclose(m_file);
+	m_file = nullptr;
+}
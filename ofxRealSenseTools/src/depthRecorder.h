@@ -0,0 +1,75 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include "ofMain.h"
+#include "depthRecording.h"
+#include "spscQueue.h"
+#include <cstdio>
+
+// Records the depth frames handed to add() into a depth recording (see
+// depthRecording.h), coding and writing them on its own thread. add() only
+// copies the samples into a free buffer; when the writer falls behind and no
+// buffer is free the frame is dropped (and counted) instead of blocking
+// update(). Every keyframeInterval-th frame is a keyframe.
+class DepthRecorder : public ofThread
+{
+
+public:
+	explicit DepthRecorder(int keyframeInterval = 30, int numBuffers = 8);
+	~DepthRecorder();
+
+	// Starts a new recording at path, relative to the data folder.
+	bool start(const std::string& path);
+	// Writes the frames still queued and the keyframe index, and closes the file.
+	void stop();
+	bool isRecording() const { return m_recording; }
+
+	// Main thread. Frames of another size than the first one are dropped.
+	void add(const rs2::depth_frame& depth);
+
+	const std::string& getPath() const { return m_path; }
+	uint64_t getRecordedFrames() const { return m_recordedFrames; }
+	uint64_t getDroppedFrames() const { return m_droppedFrames; }
+	uint64_t getBytesWritten() const { return m_bytesWritten; }
+	// raw Z16 bytes per byte written
+	float getCompressionRatio() const;
+	// "off", or the path, frames, compression ratio and dropped frames
+	std::string getSummary() const;
+
+protected:
+	void threadedFunction() override;
+
+private:
+	struct Buffer
+	{
+		std::vector<uint16_t> pixels;
+		double timestampMs = 0;
+	};
+
+	void write(Buffer& buffer);
+	bool writeBytes(const void* data, size_t size);
+	void finish();
+
+	int m_keyframeInterval;
+	std::vector<Buffer> m_buffers;
+	SpscQueue<int> m_free;   // buffers add() may fill, handed back by the writer
+	SpscQueue<int> m_filled; // buffers waiting for the writer
+
+	// set by start() and the first add(), read by the writer after it pops a buffer
+	std::string m_path;
+	int m_width = 0;
+	int m_height = 0;
+	float m_depthUnits = 0;
+	bool m_recording = false;
+
+	// writer thread
+	std::FILE* m_file = nullptr;
+	bool m_failed = false;
+	uint64_t m_offset = 0;
+	std::vector<uint16_t> m_previous;
+	std::vector<uint8_t> m_payload;
+	std::vector<DepthRecordingFormat::Keyframe> m_keyframes;
+
+	std::atomic<uint64_t> m_recordedFrames{ 0 };
+	std::atomic<uint64_t> m_droppedFrames{ 0 };
+	std::atomic<uint64_t> m_bytesWritten{ 0 };
+};
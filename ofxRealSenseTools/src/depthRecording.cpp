@@ -0,0 +1,282 @@
+#include "depthRecording.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DepthRecordingFormat;
+
+namespace {
+	void putVarint(std::vector<uint8_t>& out, uint32_t value)
+	{
+		while (value >= 0x80) {
+			out.push_back(uint8_t(value) | 0x80);
+			value >>= 7;
+		}
+		out.push_back(uint8_t(value));
+	}
+
+	bool getVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 32 && in < end; shift += 7) {
+			const uint8_t byte = *in++;
+			value |= uint32_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	// runs of zero residuals are (length - 1) << 1 | 1, anything else zigzag << 1
+	void encodeRow(const uint16_t* row, const uint16_t* previousRow, int width, std::vector<uint8_t>& out)
+	{
+		uint32_t run = 0;
+		for (int x = 0; x < width; x++) {
+			const uint16_t prediction = previousRow ? previousRow[x] : (x > 0 ? row[x - 1] : 0);
+			const int16_t residual = int16_t(uint16_t(row[x] - prediction));
+			const uint16_t zigzag = uint16_t((uint16_t(residual) << 1) ^ uint16_t(residual >> 15));
+			if (zigzag == 0) {
+				run++;
+				continue;
+			}
+			if (run > 0) {
+				putVarint(out, (run - 1) << 1 | 1);
+				run = 0;
+			}
+			putVarint(out, uint32_t(zigzag) << 1);
+		}
+		if (run > 0)
+			putVarint(out, (run - 1) << 1 | 1);
+	}
+
+	bool decodeRow(const uint8_t* in, const uint8_t* end, bool keyframe, int width, uint16_t* row)
+	{
+		int x = 0;
+		while (x < width) {
+			uint32_t token;
+			if (!getVarint(in, end, token))
+				return false;
+			if (token & 1) {
+				const uint32_t run = (token >> 1) + 1;
+				if (run > uint32_t(width - x))
+					return false;
+				// the previous frame's samples are already in place
+				if (keyframe) {
+					for (uint32_t i = 0; i < run; i++, x++)
+						row[x] = x > 0 ? row[x - 1] : 0;
+				}
+				else
+					x += run;
+			}
+			else {
+				const uint32_t zigzag = token >> 1;
+				if (zigzag > 0xffff)
+					return false;
+				const uint16_t residual = uint16_t((zigzag >> 1) ^ (0u - (zigzag & 1)));
+				const uint16_t prediction = keyframe ? (x > 0 ? row[x - 1] : 0) : row[x];
+				row[x++] = uint16_t(prediction + residual);
+			}
+		}
+		return in == end;
+	}
+}
+
+//--------------------------------------------------------------
+void DepthRecordingFormat::encodeFrame(const uint16_t* pixels, const uint16_t* previous, int width, int height, std::vector<uint8_t>& payload)
+{
+	std::vector<uint8_t> row;
+	row.reserve(width * 3);
+	for (int y = 0; y < height; y++) {
+		row.clear();
+		encodeRow(pixels + y * width, previous ? previous + y * width : nullptr, width, row);
+		putVarint(payload, uint32_t(row.size()));
+		payload.insert(payload.end(), row.begin(), row.end());
+	}
+}
+
+bool DepthRecordingFormat::decodeFrame(const uint8_t* payload, size_t size, bool keyframe, int width, int height, uint16_t* pixels)
+{
+	const uint8_t* in = payload;
+	const uint8_t* end = payload + size;
+	for (int y = 0; y < height; y++) {
+		uint32_t rowSize;
+		if (!getVarint(in, end, rowSize) || rowSize > size_t(end - in))
+			return false;
+		if (!decodeRow(in, in + rowSize, keyframe, width, pixels + y * width))
+			return false;
+		in += rowSize;
+	}
+	return in == end;
+}
+
+//--------------------------------------------------------------
+DepthRecordingReader::~DepthRecordingReader()
+{
+	close();
+}
+
+bool DepthRecordingReader::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		m_file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(m_file, &size);
+	m_size = size_t(size.QuadPart);
+	m_mapping = m_size > 0 ? CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (m_mapping)
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		m_size = size_t(info.st_size);
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+			m_data = static_cast<const uint8_t*>(data);
+	}
+	::close(file); // the mapping keeps the file open
+#endif
+	if (!m_data || m_size < sizeof(Header)) {
+		close();
+		return false;
+	}
+
+	std::memcpy(&m_header, m_data, sizeof(Header));
+	if (std::memcmp(m_header.magic, magic, sizeof(magic)) != 0 || m_header.width == 0 || m_header.height == 0) {
+		close();
+		return false;
+	}
+
+	Trailer trailer = {};
+	if (m_size >= sizeof(Header) + sizeof(Trailer))
+		std::memcpy(&trailer, m_data + m_size - sizeof(Trailer), sizeof(Trailer));
+	const uint64_t keyframesSize = uint64_t(trailer.numKeyframes) * sizeof(Keyframe);
+	if (std::memcmp(trailer.magic, indexMagic, sizeof(indexMagic)) == 0
+		&& trailer.keyframesOffset >= sizeof(Header)
+		&& trailer.keyframesOffset + keyframesSize + sizeof(Trailer) == m_size) {
+		m_keyframes.resize(trailer.numKeyframes);
+		if (!m_keyframes.empty())
+			std::memcpy(m_keyframes.data(), m_data + trailer.keyframesOffset, keyframesSize);
+		m_framesEnd = trailer.keyframesOffset;
+		m_numFrames = int(trailer.numFrames);
+	}
+	else if (!indexFrames()) {
+		close();
+		return false;
+	}
+
+	if (m_keyframes.empty() || m_keyframes.front().frame != 0) {
+		close();
+		return false;
+	}
+	m_current.assign(size_t(m_header.width) * m_header.height, 0);
+	return true;
+}
+
+bool DepthRecordingReader::indexFrames()
+{
+	uint64_t offset = sizeof(Header);
+	FrameHeader frame;
+	while (readFrameHeader(offset, frame)) {
+		if (frame.flags & keyframeFlag)
+			m_keyframes.push_back(Keyframe{ uint64_t(m_numFrames), offset });
+		offset += sizeof(FrameHeader) + frame.payloadSize;
+		m_numFrames++;
+	}
+	m_framesEnd = offset; // a frame cut short by a crash is left out
+	return m_numFrames > 0;
+}
+
+void DepthRecordingReader::close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_data)
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_header = Header();
+	m_keyframes.clear();
+	m_framesEnd = 0;
+	m_numFrames = 0;
+	m_currentFrame = -1;
+}
+
+bool DepthRecordingReader::readFrameHeader(uint64_t offset, FrameHeader& header) const
+{
+	const uint64_t end = m_framesEnd > 0 ? m_framesEnd : m_size;
+	if (offset + sizeof(FrameHeader) > end)
+		return false;
+	// frames are packed back to back, so the header may not be aligned
+	std::memcpy(&header, m_data + offset, sizeof(FrameHeader));
+	return offset + sizeof(FrameHeader) + header.payloadSize <= end;
+}
+
+bool DepthRecordingReader::decode(int frame, uint16_t* pixels, double& timestampMs)
+{
+	if (!isOpen() || frame < 0 || frame >= m_numFrames)
+		return false;
+
+	auto keyframe = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), uint64_t(frame),
+		[](uint64_t value, const Keyframe& key) { return value < key.frame; });
+	--keyframe; // the first keyframe is frame 0
+
+	int next;
+	uint64_t offset;
+	if (m_currentFrame >= int(keyframe->frame) && m_currentFrame <= frame) {
+		next = m_currentFrame + 1;
+		offset = m_nextOffset;
+	}
+	else {
+		next = int(keyframe->frame);
+		offset = keyframe->offset;
+	}
+
+	const int width = m_header.width;
+	const int height = m_header.height;
+	for (; next <= frame; next++) {
+		FrameHeader header;
+		const bool valid = readFrameHeader(offset, header);
+		const bool isKeyframe = valid && (header.flags & keyframeFlag);
+		if (!valid
+			|| (next == int(keyframe->frame) && !isKeyframe)
+			|| !decodeFrame(m_data + offset + sizeof(FrameHeader), header.payloadSize, isKeyframe, width, height, m_current.data())) {
+			m_currentFrame = -1;
+			return false;
+		}
+		m_currentFrame = next;
+		m_currentTimestamp = header.timestampMs;
+		offset += sizeof(FrameHeader) + header.payloadSize;
+		m_nextOffset = offset;
+	}
+
+	std::copy(m_current.begin(), m_current.end(), pixels);
+	timestampMs = m_currentTimestamp;
+	return true;
+}
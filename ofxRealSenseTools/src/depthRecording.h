@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Depth recordings (.rsdepth) are a header, the frames one after the other and
+// a footer with the position of every keyframe:
+//
+//   Header        magic "RSDEPTH1", width, height, depthUnits, keyframeInterval
+//   Frame ...     flags (keyframe), payload size, timestamp in ms, payload
+//   Keyframes ... frame number and file offset of every keyframe
+//   Trailer       offset of the keyframes, their count, the frame count, "RSDINDEX"
+//
+// A payload is one coded row after the other, each prefixed with its size.
+// Keyframe samples are predicted from their left neighbour, the others from
+// the same sample of the previous frame. The residuals are zigzag varints,
+// with runs of zero residuals (a still scene) collapsed into one varint.
+namespace DepthRecordingFormat
+{
+	const char magic[8] = { 'R', 'S', 'D', 'E', 'P', 'T', 'H', '1' };
+	const char indexMagic[8] = { 'R', 'S', 'D', 'I', 'N', 'D', 'E', 'X' };
+	const uint8_t keyframeFlag = 0x1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t width;
+		uint32_t height;
+		float depthUnits;
+		uint32_t keyframeInterval;
+	};
+
+	struct FrameHeader
+	{
+		uint32_t flags;
+		uint32_t payloadSize;
+		double timestampMs;
+	};
+
+	struct Keyframe
+	{
+		uint64_t frame;
+		uint64_t offset; // of its FrameHeader
+	};
+
+	struct Trailer
+	{
+		uint64_t keyframesOffset;
+		uint32_t numKeyframes;
+		uint32_t numFrames;
+		char magic[8];
+	};
+
+	// Appends the coded rows of a width x height frame to payload. previous is
+	// the frame before, or nullptr for a keyframe.
+	void encodeFrame(const uint16_t* pixels, const uint16_t* previous, int width, int height, std::vector<uint8_t>& payload);
+
+	// Decodes a payload into pixels. For a frame that isn't a keyframe pixels
+	// must hold the previous frame, which is overwritten in place. Returns false
+	// if the payload is malformed.
+	bool decodeFrame(const uint8_t* payload, size_t size, bool keyframe, int width, int height, uint16_t* pixels);
+}
+
+// Random access to a depth recording through a read-only memory mapping.
+// decode() starts from the nearest keyframe at or before the requested frame,
+// or carries on from the frame it decoded last when that is closer, so any
+// frame costs at most a keyframe interval of decoding and playing frames in
+// order costs one each. Recordings without a footer (the recorder never
+// stopped) are indexed by walking the frame headers once on open().
+class DepthRecordingReader
+{
+
+public:
+	~DepthRecordingReader();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return m_data != nullptr; }
+
+	int getWidth() const { return m_header.width; }
+	int getHeight() const { return m_header.height; }
+	float getDepthUnits() const { return m_header.depthUnits; }
+	int getNumFrames() const { return m_numFrames; }
+	int getNumKeyframes() const { return int(m_keyframes.size()); }
+
+	// Fills pixels (width * height samples) with frame, and its timestamp.
+	// Returns false if the frame is out of range or corrupt.
+	bool decode(int frame, uint16_t* pixels, double& timestampMs);
+
+private:
+	// false if no whole frame starts at offset
+	bool readFrameHeader(uint64_t offset, DepthRecordingFormat::FrameHeader& header) const;
+	bool indexFrames();
+
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+	DepthRecordingFormat::Header m_header = {};
+	std::vector<DepthRecordingFormat::Keyframe> m_keyframes;
+	uint64_t m_framesEnd = 0; // offset past the last frame
+	int m_numFrames = 0;
+
+	std::vector<uint16_t> m_current;
+	int m_currentFrame = -1; // held in m_current, -1 for none
+	uint64_t m_nextOffset = 0; // of the frame after it
+	double m_currentTimestamp = 0;
+};
@@ -0,0 +1,157 @@
+#include "depthRoi.h"
+#include <algorithm>
+
+float averageRoiDistance(const rs2::depth_frame& depthFrame, int roiColumns, int roiRows, float minDistance)
+{
+	std::vector<float> distances;
+
+	// Get the depth frame's dimensions
+	const int width = depthFrame.get_width();
+	const int height = depthFrame.get_height();
+
+	const auto window_corner_x = (width - roiColumns) / 2;
+	const auto window_corner_y = (height - roiRows) / 2;
+
+	for (auto i = 0; i < roiRows; i++)
+	{
+		for (auto j = 0; j < roiColumns; j++)
+		{
+			auto sample_cell_x = window_corner_x + j;
+			auto sample_cell_y = window_corner_y + i;
+			float dist_at_cell = depthFrame.get_distance(sample_cell_x, sample_cell_y);
+			distances.push_back(dist_at_cell);
+		}
+	}
+
+	// filter out zeros using `Erase-remove idiom`
+	distances.erase(std::remove_if(distances.begin(), distances.end(), [minDistance](float distance) {return distance < minDistance; }), distances.end());
+	float sum = 0;
+	for (auto& distance_sample : distances) {
+		sum += distance_sample;
+	}
+	return sum / distances.size();
+}
+
+namespace {
+	// smallest raw value whose distance is at least the given one, the same
+	// float comparison the get_distance() filter makes
+	uint16_t firstRawAtLeast(float distance, float depthUnits)
+	{
+		double raw = std::ceil(distance / depthUnits);
+		raw = std::min(std::max(raw, 1.0), 65535.0);
+		while (raw > 1 && float(raw - 1) * depthUnits >= distance)
+			raw--;
+		while (raw < 65535 && float(raw) * depthUnits < distance)
+			raw++;
+		return uint16_t(raw);
+	}
+}
+
+DepthRoiStats::DepthRoiStats(float minDistance, float maxDistance, int medianBins)
+	: m_minDistance(minDistance)
+	, m_maxDistance(std::max(maxDistance, minDistance))
+	, m_medianBins(std::max(0, medianBins))
+	, m_channels(std::max(1, m_medianBins))
+{
+	m_edges.resize(m_channels);
+	m_rowCounts.resize(m_channels);
+}
+
+void DepthRoiStats::update(const DepthView& depth, float depthUnits)
+{
+	if (depth.width != m_width || depth.height != m_height) {
+		m_width = depth.width;
+		m_height = depth.height;
+		m_sums.assign((m_width + 1) * (m_height + 1), 0);
+		m_counts.assign((m_width + 1) * (m_height + 1) * m_channels, 0);
+	}
+	if (depthUnits != m_depthUnits) {
+		m_depthUnits = depthUnits;
+		const float binWidth = m_medianBins > 0 ? (m_maxDistance - m_minDistance) / m_medianBins : 0;
+		for (int channel = 0; channel < m_channels; channel++)
+			m_edges[channel] = firstRawAtLeast(m_minDistance + channel * binWidth, depthUnits);
+	}
+
+	const int stride = m_width + 1;
+	const uint16_t minRaw = m_edges[0];
+	for (int y = 0; y < m_height; y++) {
+		const uint16_t* depthRow = depth.row(y);
+		const uint64_t* sumsAbove = &m_sums[y * stride];
+		uint64_t* sums = &m_sums[(y + 1) * stride];
+		const uint32_t* countsAbove = &m_counts[y * stride * m_channels];
+		uint32_t* counts = &m_counts[(y + 1) * stride * m_channels];
+
+		// running totals along the row plus the table entry above
+		uint64_t rowSum = 0;
+		if (m_channels == 1) {
+			// no median bins, only the valid count
+			uint32_t rowCount = 0;
+			for (int x = 0; x < m_width; x++) {
+				const uint16_t raw = depthRow[x];
+				const bool valid = raw >= minRaw;
+				rowSum += valid ? raw : 0;
+				rowCount += valid;
+				sums[x + 1] = sumsAbove[x + 1] + rowSum;
+				counts[x + 1] = countsAbove[x + 1] + rowCount;
+			}
+			continue;
+		}
+		std::fill(m_rowCounts.begin(), m_rowCounts.end(), 0);
+		for (int x = 0; x < m_width; x++) {
+			const uint16_t raw = depthRow[x];
+			if (raw >= minRaw) {
+				rowSum += raw;
+				m_rowCounts[0]++;
+				for (int channel = 1; channel < m_channels; channel++)
+					m_rowCounts[channel] += raw < m_edges[channel];
+			}
+			sums[x + 1] = sumsAbove[x + 1] + rowSum;
+			const int entry = (x + 1) * m_channels;
+			for (int channel = 0; channel < m_channels; channel++)
+				counts[entry + channel] = countsAbove[entry + channel] + m_rowCounts[channel];
+		}
+	}
+}
+
+DepthRoiStats::Stats DepthRoiStats::query(int x, int y, int width, int height) const
+{
+	Stats stats;
+	const int left = std::max(0, x);
+	const int top = std::max(0, y);
+	const int right = std::min(m_width, x + width);
+	const int bottom = std::min(m_height, y + height);
+	if (right <= left || bottom <= top)
+		return stats;
+	stats.area = (right - left) * (bottom - top);
+
+	// unsigned wrap-around cancels out in the four corner sum
+	const int stride = m_width + 1;
+	const int topLeft = top * stride + left;
+	const int topRight = top * stride + right;
+	const int bottomLeft = bottom * stride + left;
+	const int bottomRight = bottom * stride + right;
+	auto count = [&](int channel) {
+		return m_counts[bottomRight * m_channels + channel] - m_counts[bottomLeft * m_channels + channel]
+			- m_counts[topRight * m_channels + channel] + m_counts[topLeft * m_channels + channel];
+	};
+	stats.validCount = int(count(0));
+	if (stats.validCount == 0)
+		return stats;
+
+	const uint64_t sum = m_sums[bottomRight] - m_sums[bottomLeft] - m_sums[topRight] + m_sums[topLeft];
+	stats.mean = float(double(sum) * m_depthUnits / stats.validCount);
+
+	// the bin holding the middle sample, then linearly within it
+	const float binWidth = (m_maxDistance - m_minDistance) / m_medianBins;
+	const float half = stats.validCount * 0.5f;
+	uint32_t below = 0;
+	for (int bin = 0; bin < m_medianBins; bin++) {
+		const uint32_t belowNext = bin + 1 < m_medianBins ? count(bin + 1) : uint32_t(stats.validCount);
+		if (belowNext >= half && belowNext > below) {
+			stats.median = m_minDistance + (bin + (half - below) / (belowNext - below)) * binWidth;
+			break;
+		}
+		below = belowNext;
+	}
+	return stats;
+}
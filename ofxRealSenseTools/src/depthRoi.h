@@ -0,0 +1,59 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include "depthView.h"
+#include <cmath>
+#include <vector>
+
+// ofxBox2d calculateDepth(): average distance in metres over a roiColumns x roiRows
+// window in the centre of the depth frame, ignoring samples closer than minDistance.
+// Returns NaN when every sample in the window was ignored. Reads the window with
+// get_distance(); DepthRoiStats answers the same from one pass over the frame.
+float averageRoiDistance(const rs2::depth_frame& depthFrame, int roiColumns, int roiRows, float minDistance);
+
+// Summed-area tables of one depth frame. After update() the statistics of any
+// rectangle come from a few table reads, so any number of zones costs the same
+// as one. Samples closer than minDistance, and the invalid 0s, are left out.
+class DepthRoiStats
+{
+
+public:
+	struct Stats
+	{
+		int area = 0; // pixels of the rectangle inside the frame
+		int validCount = 0;
+		float mean = NAN; // metres, NaN without valid samples
+		float median = NAN; // metres, interpolated within its histogram bin; NaN without bins
+
+		float getValidRatio() const { return area > 0 ? float(validCount) / area : 0; }
+	};
+
+	// The median comes from a histogram of medianBins bins from minDistance to
+	// maxDistance; samples beyond maxDistance count towards the last one. Every
+	// bin is another table as large as the frame, so with medianBins 0, for
+	// callers that only need the mean, update() builds just the sums and valid
+	// counts and the median stays NaN.
+	DepthRoiStats(float minDistance = 0.1f, float maxDistance = 4.0f, int medianBins = 8);
+
+	// Builds the tables for a frame. Only allocates when the frame size changes.
+	void update(const DepthView& depth, float depthUnits);
+
+	// Statistics of the width x height pixels from (x, y), clipped to the frame.
+	Stats query(int x, int y, int width, int height) const;
+
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+
+private:
+	float m_minDistance;
+	float m_maxDistance;
+	int m_medianBins;
+	int m_channels; // valid count, then the count below each inner bin edge
+	float m_depthUnits = 0;
+	int m_width = 0;
+	int m_height = 0;
+
+	std::vector<uint16_t> m_edges; // raw value each channel counts below, [0] the first valid one
+	std::vector<uint64_t> m_sums; // (width + 1) x (height + 1) raw sums, first row and column 0
+	std::vector<uint32_t> m_counts; // the same, m_channels per entry
+	std::vector<uint32_t> m_rowCounts;
+};
@@ -0,0 +1,89 @@
+#include "depthSource.h"
+#include "recordedDepthSource.h"
+#include "syntheticDepthSource.h"
+#include "ofMain.h"
+#include <cctype>
+
+//--------------------------------------------------------------
+void LiveDepthSource::start()
+{
+	m_pipe.start();
+}
+
+void LiveDepthSource::stop()
+{
+	m_pipe.stop();
+}
+
+rs2::frame LiveDepthSource::waitForFrame(unsigned int timeoutMs)
+{
+	rs2::frameset frames;
+	if (!m_pipe.try_wait_for_frames(&frames, timeoutMs))
+		return rs2::frame();
+	return frames.get_depth_frame();
+}
+
+std::string LiveDepthSource::getDescription() const
+{
+	return "live";
+}
+
+//--------------------------------------------------------------
+BagDepthSource::BagDepthSource(const std::string& path) : m_path(path)
+{
+}
+
+void BagDepthSource::start()
+{
+	rs2::config config;
+	config.enable_device_from_file(ofToDataPath(m_path, true), true);
+	auto profile = m_pipe.start(config);
+	// don't throttle to the recorded frame rate, hand frames out as fast as they are read
+	profile.get_device().as<rs2::playback>().set_real_time(false);
+}
+
+void BagDepthSource::stop()
+{
+	m_pipe.stop();
+}
+
+rs2::frame BagDepthSource::waitForFrame(unsigned int timeoutMs)
+{
+	rs2::frameset frames;
+	if (!m_pipe.try_wait_for_frames(&frames, timeoutMs))
+		return rs2::frame();
+	return frames.get_depth_frame();
+}
+
+std::string BagDepthSource::getDescription() const
+{
+	return "bag:" + m_path;
+}
+
+//--------------------------------------------------------------
+std::unique_ptr<DepthSource> createDepthSource(const std::string& description)
+{
+	if (description.empty() || description == "live")
+		return std::make_unique<LiveDepthSource>();
+
+	if (description.compare(0, 4, "bag:") == 0)
+		return std::make_unique<BagDepthSource>(description.substr(4));
+	if (description.size() > 4 && description.compare(description.size() - 4, 4, ".bag") == 0)
+		return std::make_unique<BagDepthSource>(description);
+
+	if (description.compare(0, 10, "recording:") == 0) {
+		const std::string path = description.substr(10);
+		const auto at = path.rfind('@');
+		if (at != std::string::npos && at + 1 < path.size() && std::isdigit(path[at + 1]))
+			return std::make_unique<RecordedDepthSource>(path.substr(0, at), std::atoi(path.c_str() + at + 1));
+		return std::make_unique<RecordedDepthSource>(path);
+	}
+	if (description.size() > 8 && description.compare(description.size() - 8, 8, ".rsdepth") == 0)
+		return std::make_unique<RecordedDepthSource>(description);
+
+	if (description.compare(0, 9, "synthetic") == 0)
+		return std::make_unique<SyntheticDepthSource>(parseSyntheticDepthSettings(description));
+
+	ofLogError("createDepthSource") << "unknown depth source '" << description << "', using the live camera";
+	return std::make_unique<LiveDepthSource>();
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include <memory>
+#include <string>
+
+// Where DepthCapture gets its frames from. Lets the apps run their geometry
+// pipeline against a live camera, a recorded .bag or a synthetic scene
+// without any other change.
+class DepthSource
+{
+
+public:
+	virtual ~DepthSource() {}
+
+	virtual void start() = 0;
+	virtual void stop() = 0;
+
+	// Blocks until the next depth frame, or returns an empty frame on timeout.
+	virtual rs2::frame waitForFrame(unsigned int timeoutMs) = 0;
+
+	virtual std::string getDescription() const = 0;
+};
+
+// The attached RealSense device, default depth stream.
+class LiveDepthSource : public DepthSource
+{
+
+public:
+	void start() override;
+	void stop() override;
+	rs2::frame waitForFrame(unsigned int timeoutMs) override;
+	std::string getDescription() const override;
+
+private:
+	rs2::pipeline m_pipe;
+};
+
+// A recorded .bag file, played back as fast as frames are consumed and looped.
+class BagDepthSource : public DepthSource
+{
+
+public:
+	explicit BagDepthSource(const std::string& path);
+
+	void start() override;
+	void stop() override;
+	rs2::frame waitForFrame(unsigned int timeoutMs) override;
+	std::string getDescription() const override;
+
+private:
+	std::string m_path;
+	rs2::pipeline m_pipe;
+};
+
+// Builds a source from a command line style description:
+//   live                                   the attached camera (default)
+//   bag:<path> or <path>.bag               recorded playback
+//   recording:<path>[@frame] or <path>.rsdepth
+//                                          DepthRecorder playback, optionally from a frame on
+//   synthetic[:scene][:WxH][@fps][:noise=m][:dropout=r]
+//                                          generated frames, see SyntheticDepthSource
+std::unique_ptr<DepthSource> createDepthSource(const std::string& description);
@@ -0,0 +1,38 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include <cstdint>
+
+// Direct read access to the raw Z16 samples of a depth frame.
+// Grabs the data pointer and stride once instead of going through
+// rs2::depth_frame::get_distance() for every pixel.
+struct DepthView
+{
+	const uint16_t* data = nullptr;
+	int width = 0;
+	int height = 0;
+	int stride = 0; // in samples, not bytes
+
+	static DepthView fromFrame(const rs2::depth_frame& depth)
+	{
+		DepthView view;
+		view.data = static_cast<const uint16_t*>(depth.get_data());
+		view.width = depth.get_width();
+		view.height = depth.get_height();
+		view.stride = depth.get_stride_in_bytes() / sizeof(uint16_t);
+		return view;
+	}
+
+	// A view of a plain width x height array of samples.
+	static DepthView fromSamples(const uint16_t* samples, int width, int height)
+	{
+		DepthView view;
+		view.data = samples;
+		view.width = width;
+		view.height = height;
+		view.stride = width;
+		return view;
+	}
+
+	const uint16_t* row(int y) const { return data + y * stride; }
+	uint16_t at(int x, int y) const { return data[y * stride + x]; }
+};
@@ -0,0 +1,111 @@
+#include "dirtyTiles.h"
+#include "meshKernels.h"
+#include "workerPool.h"
+#include <cstdlib>
+
+int DirtyTiles::update(const DepthView& depth, const DepthSampling& sampling, float depthUnits, float threshold, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	const int rows = sampling.getRows();
+	if (columns != m_columns || rows != m_rows) {
+		m_columns = columns;
+		m_rows = rows;
+		m_tileColumns = (columns + m_tileSize - 1) / m_tileSize;
+		m_tileRows = (rows + m_tileSize - 1) / m_tileSize;
+		m_reference.assign(columns * rows, 0);
+		m_dirty.assign(m_tileColumns * m_tileRows, 0);
+		m_requested.assign(m_tileColumns * m_tileRows, 0);
+		m_dirtyPerTileRow.assign(m_tileRows, 0);
+		m_valid = false;
+	}
+
+	// compare in raw units, so the samples never need converting
+	const int rawThreshold = depthUnits > 0 ? int(std::min(65535.0f, threshold / depthUnits)) : 0;
+	const bool compare = m_valid;
+	const int stride = sampling.getSampleStride();
+
+	auto updateTileRow = [&](int tileRow) {
+		const int firstRow = tileRow * m_tileSize;
+		const int endRow = std::min(rows, firstRow + m_tileSize);
+		int numDirty = 0;
+		for (int tileColumn = 0; tileColumn < m_tileColumns; tileColumn++) {
+			const int firstColumn = tileColumn * m_tileSize;
+			const int endColumn = std::min(columns, firstColumn + m_tileSize);
+
+			bool dirty = !compare;
+			for (int row = firstRow; row < endRow && !dirty; row++) {
+				const uint16_t* depthRow = sampling.getSampleRow(depth, row);
+				const uint16_t* reference = &m_reference[row * columns];
+				for (int column = firstColumn; column < endColumn; column++) {
+					if (std::abs(int(depthRow[column * stride]) - int(reference[column])) > rawThreshold) {
+						dirty = true;
+						break;
+					}
+				}
+			}
+
+			m_dirty[tileRow * m_tileColumns + tileColumn] = dirty;
+			if (!dirty)
+				continue;
+			numDirty++;
+			// the tile is rebuilt from these samples, so they are what later frames compare against
+			for (int row = firstRow; row < endRow; row++) {
+				const uint16_t* depthRow = sampling.getSampleRow(depth, row);
+				uint16_t* reference = &m_reference[row * columns];
+				for (int column = firstColumn; column < endColumn; column++)
+					reference[column] = depthRow[column * stride];
+			}
+		}
+		m_dirtyPerTileRow[tileRow] = numDirty;
+	};
+
+	if (pool)
+		pool->parallelFor(m_tileRows, updateTileRow);
+	else {
+		for (int tileRow = 0; tileRow < m_tileRows; tileRow++)
+			updateTileRow(tileRow);
+	}
+
+	m_valid = true;
+	m_numDirty = 0;
+	for (int numDirty : m_dirtyPerTileRow)
+		m_numDirty += numDirty;
+
+	m_counters.frames++;
+	m_counters.tiles += getNumTiles();
+	m_counters.dirtyTiles += m_numDirty;
+	if (m_numDirty == 0)
+		m_counters.skippedFrames++;
+	return m_numDirty;
+}
+
+void DirtyTiles::markDirty(int tileColumn, int tileRow)
+{
+	auto& dirty = m_dirty[tileRow * m_tileColumns + tileColumn];
+	if (dirty)
+		return;
+	dirty = 1;
+	m_dirtyPerTileRow[tileRow]++;
+	m_numDirty++;
+	m_counters.dirtyTiles++;
+}
+
+void DirtyTiles::markDirtyRows()
+{
+	for (int tileRow = 0; tileRow < m_tileRows; tileRow++) {
+		if (m_dirtyPerTileRow[tileRow] == 0)
+			continue;
+		for (int tileColumn = 0; tileColumn < m_tileColumns; tileColumn++)
+			markDirty(tileColumn, tileRow);
+	}
+}
+
+void DirtyTiles::applyDirtyRequests()
+{
+	for (int tile = 0; tile < int(m_requested.size()); tile++) {
+		if (!m_requested[tile])
+			continue;
+		m_requested[tile] = 0;
+		markDirty(tile % m_tileColumns, tile / m_tileColumns);
+	}
+}
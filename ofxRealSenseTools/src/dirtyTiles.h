@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "depthView.h"
+
+struct DepthSampling;
+class WorkerPool;
+
+// Change detection for mostly static scenes. The sampling grid is cut into
+// square tiles of tileSize x tileSize samples; update() compares the sampled
+// raw depth of every tile with what it held when the tile was last rebuilt and
+// marks the tile dirty if any sample moved by more than the threshold. Only
+// dirty tiles need their vertices recomputed and re-uploaded, and a frame
+// without dirty tiles can be skipped entirely.
+class DirtyTiles
+{
+
+public:
+	struct Counters
+	{
+		uint64_t frames = 0;
+		uint64_t skippedFrames = 0; // frames without a single dirty tile
+		uint64_t tiles = 0;         // tiles checked, over all frames
+		uint64_t dirtyTiles = 0;    // tiles rebuilt, over all frames
+
+		float getDirtyFraction() const { return tiles > 0 ? float(dirtyTiles) / tiles : 0; }
+	};
+
+	explicit DirtyTiles(int tileSize = 16) : m_tileSize(std::max(1, tileSize)) {}
+
+	// Forgets the reference samples, so the next update() marks every tile
+	// dirty. Call it whenever something besides the depth changes the mesh.
+	void invalidate() { m_valid = false; }
+
+	// Compares the samples of depth with the reference and marks the tiles
+	// that changed by more than threshold metres dirty; their samples become
+	// the new reference. A new grid shape marks every tile dirty. Returns the
+	// number of dirty tiles.
+	int update(const DepthView& depth, const DepthSampling& sampling, float depthUnits, float threshold, WorkerPool* pool = nullptr);
+
+	// Marks a tile dirty after update(), e.g. because a result that reaches
+	// across tiles changed there.
+	void markDirty(int tileColumn, int tileRow);
+	// Extends every dirty tile to its whole tile row, for kernels whose
+	// output depends on complete sample rows.
+	void markDirtyRows();
+	// markDirty() for tiles found by several threads at once: requestDirty()
+	// only flags the tile, so it is safe as long as each tile is requested
+	// from one thread, and applyDirtyRequests() then marks the flagged ones.
+	void requestDirty(int tileColumn, int tileRow) { m_requested[tileRow * m_tileColumns + tileColumn] = 1; }
+	void applyDirtyRequests();
+
+	// Shape of the sampling grid of the last update().
+	int getColumns() const { return m_columns; }
+	int getRows() const { return m_rows; }
+	int getTileSize() const { return m_tileSize; }
+	int getTileColumns() const { return m_tileColumns; }
+	int getTileRows() const { return m_tileRows; }
+	int getNumTiles() const { return m_tileColumns * m_tileRows; }
+	int getNumDirtyTiles() const { return m_numDirty; }
+	bool isDirty(int tileColumn, int tileRow) const { return m_dirty[tileRow * m_tileColumns + tileColumn] != 0; }
+	bool isAllDirty() const { return m_numDirty == getNumTiles(); }
+	// Fraction of the tiles that are dirty this frame.
+	float getDirtyFraction() const { return getNumTiles() > 0 ? float(m_numDirty) / getNumTiles() : 0; }
+
+	// Calls body(row, firstColumn, endColumn) for every sample row of tileRow,
+	// once per run of adjacent dirty tiles, in memory order.
+	template <typename Body>
+	void forEachDirtySpan(int tileRow, Body body) const
+	{
+		const int firstRow = tileRow * m_tileSize;
+		const int endRow = std::min(m_rows, firstRow + m_tileSize);
+		for (int row = firstRow; row < endRow; row++) {
+			int tileColumn = 0;
+			while (tileColumn < m_tileColumns) {
+				if (!isDirty(tileColumn, tileRow)) {
+					tileColumn++;
+					continue;
+				}
+				int endTile = tileColumn + 1;
+				while (endTile < m_tileColumns && isDirty(endTile, tileRow))
+					endTile++;
+				body(row, tileColumn * m_tileSize, std::min(m_columns, endTile * m_tileSize));
+				tileColumn = endTile;
+			}
+		}
+	}
+
+	// forEachDirtySpan() over every tile row.
+	template <typename Body>
+	void forEachDirtySpan(Body body) const
+	{
+		for (int tileRow = 0; tileRow < m_tileRows; tileRow++)
+			forEachDirtySpan(tileRow, body);
+	}
+
+	const Counters& getCounters() const { return m_counters; }
+	void resetCounters() { m_counters = Counters(); }
+
+private:
+	int m_tileSize;
+	int m_columns = 0;
+	int m_rows = 0;
+	int m_tileColumns = 0;
+	int m_tileRows = 0;
+	bool m_valid = false;
+	int m_numDirty = 0;
+	std::vector<uint16_t> m_reference; // columns x rows raw samples as of each tile's last rebuild
+	std::vector<uint8_t> m_dirty;
+	std::vector<uint8_t> m_requested; // by requestDirty(), until applyDirtyRequests()
+	std::vector<int> m_dirtyPerTileRow;
+	Counters m_counters;
+};
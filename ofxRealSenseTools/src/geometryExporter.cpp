@@ -0,0 +1,328 @@
+#include "geometryExporter.h"
+#include "gridMesh.h"
+#include <cstring>
+
+namespace {
+	const char streamMagic[8] = { 'R', 'S', 'P', 'O', 'I', 'N', 'T', 'S' };
+	const char frameMagic[4] = { 'F', 'R', 'M', 'E' };
+	const uint32_t streamVersion = 1;
+	const uint32_t indicesFlag = 0x1;
+
+	struct StreamFrameHeader
+	{
+		char magic[4];
+		uint32_t flags;
+		uint32_t numVertices;
+		uint32_t numIndices;
+		uint32_t mode;
+		uint32_t reserved;
+		uint64_t frame;
+	};
+
+	// Appends the triangles (3 corners each) or edges (2 each) that indices
+	// drawn as mode make up to corners, splitting strips, loops and fans at
+	// GridMesh::restartIndex and leaving out any that reach past numVertices.
+	// Returns the corners per primitive, 0 for points.
+	int collectPrimitives(const std::vector<ofIndexType>& indices, ofPrimitiveMode mode, uint32_t numVertices, std::vector<uint32_t>& corners)
+	{
+		int perPrimitive;
+		switch (mode) {
+		case OF_PRIMITIVE_TRIANGLES:
+		case OF_PRIMITIVE_TRIANGLE_STRIP:
+		case OF_PRIMITIVE_TRIANGLE_FAN:
+			perPrimitive = 3;
+			break;
+		case OF_PRIMITIVE_LINES:
+		case OF_PRIMITIVE_LINE_STRIP:
+		case OF_PRIMITIVE_LINE_LOOP:
+			perPrimitive = 2;
+			break;
+		default:
+			return 0;
+		}
+
+		auto add = [&](uint32_t a, uint32_t b, uint32_t c) {
+			if (a >= numVertices || b >= numVertices || (perPrimitive == 3 && c >= numVertices))
+				return;
+			corners.push_back(a);
+			corners.push_back(b);
+			if (perPrimitive == 3)
+				corners.push_back(c);
+		};
+
+		size_t start = 0;
+		for (size_t end = 0; end <= indices.size(); end++) {
+			if (end < indices.size() && indices[end] != GridMesh::restartIndex)
+				continue;
+			const ofIndexType* p = indices.data() + start;
+			const size_t n = end - start;
+			start = end + 1;
+
+			switch (mode) {
+			case OF_PRIMITIVE_TRIANGLES:
+				for (size_t i = 0; i + 2 < n; i += 3)
+					add(p[i], p[i + 1], p[i + 2]);
+				break;
+			case OF_PRIMITIVE_TRIANGLE_STRIP:
+				// every other triangle of a strip is wound the other way round
+				for (size_t i = 2; i < n; i++) {
+					if (p[i] == p[i - 1] || p[i] == p[i - 2] || p[i - 1] == p[i - 2])
+						continue; // degenerate
+					if (i % 2)
+						add(p[i - 1], p[i - 2], p[i]);
+					else
+						add(p[i - 2], p[i - 1], p[i]);
+				}
+				break;
+			case OF_PRIMITIVE_TRIANGLE_FAN:
+				for (size_t i = 2; i < n; i++)
+					add(p[0], p[i - 1], p[i]);
+				break;
+			case OF_PRIMITIVE_LINES:
+				for (size_t i = 0; i + 1 < n; i += 2)
+					add(p[i], p[i + 1], 0);
+				break;
+			default: // strips and loops
+				for (size_t i = 1; i < n; i++)
+					add(p[i - 1], p[i], 0);
+				if (mode == OF_PRIMITIVE_LINE_LOOP && n > 2)
+					add(p[n - 1], p[0], 0);
+				break;
+			}
+		}
+		return perPrimitive;
+	}
+}
+
+//--------------------------------------------------------------
+GeometryExporter::GeometryExporter(int numBuffers)
+	: m_jobs(std::max(1, numBuffers))
+	, m_free(m_jobs.size())
+	, m_queued(m_jobs.size())
+{
+	for (int i = 0; i < int(m_jobs.size()); i++)
+		m_free.push(i);
+}
+
+GeometryExporter::~GeometryExporter()
+{
+	stop();
+}
+
+void GeometryExporter::requestSnapshot(const std::string& path)
+{
+	m_snapshotPath = ofToDataPath(path, true);
+	ensureThread();
+}
+
+void GeometryExporter::startStream(const std::string& path)
+{
+	stopStream();
+	m_streamPath = path;
+	m_streamDataPath = ofToDataPath(path, true);
+	m_streamId++;
+	m_streaming = true;
+	ensureThread();
+}
+
+void GeometryExporter::stopStream()
+{
+	if (!m_streaming)
+		return;
+	m_streaming = false;
+	// after the stream's last frame was queued
+	m_closeStreamId = m_streamId;
+}
+
+void GeometryExporter::stop()
+{
+	m_streaming = false;
+	m_snapshotPath.clear();
+	if (isThreadRunning())
+		waitForThread(true); // the writer drains the queue and closes the stream first
+}
+
+void GeometryExporter::ensureThread()
+{
+	if (!isThreadRunning())
+		startThread();
+}
+
+void GeometryExporter::submit(const std::vector<glm::vec3>& vertices, int numVertices,
+	const std::vector<ofIndexType>& indices, uint64_t indicesVersion, ofPrimitiveMode mode)
+{
+	if (m_snapshotPath.empty() && !m_streaming)
+		return;
+	// dropped frames leave a gap in the stream's frame numbers
+	const uint64_t frame = m_submittedFrames++;
+	int index;
+	if (!m_free.pop(index)) {
+		m_droppedFrames++; // a snapshot waits for the next frame
+		return;
+	}
+
+	// into storage that is reused frame after frame, so this doesn't allocate
+	Job& job = m_jobs[index];
+	numVertices = std::max(0, std::min(numVertices, int(vertices.size())));
+	job.vertices.assign(vertices.begin(), vertices.begin() + numVertices);
+	job.mode = mode;
+	job.newIndices = mode != OF_PRIMITIVE_POINTS && (!m_hasTakenIndices || indicesVersion != m_takenIndicesVersion);
+	if (job.newIndices) {
+		job.indices.assign(indices.begin(), indices.end());
+		m_takenIndicesVersion = indicesVersion;
+		m_hasTakenIndices = true;
+	}
+	job.frame = frame;
+	job.snapshotPath = m_snapshotPath;
+	m_snapshotPath.clear();
+	job.streamId = m_streaming ? m_streamId : 0;
+	job.streamPath = m_streamDataPath;
+	m_queued.push(index);
+}
+
+std::string GeometryExporter::getSummary() const
+{
+	if (!m_streaming)
+		return "off";
+	return m_streamPath + ", " + ofToString(getWrittenFrames()) + " frames, " + ofToString(getDroppedFrames()) + " dropped";
+}
+
+void GeometryExporter::threadedFunction()
+{
+	int index;
+	while (true) {
+		if (m_queued.pop(index)) {
+			write(m_jobs[index]);
+			m_free.push(index);
+			continue;
+		}
+		// both are only set after the last frame they concern was queued, so
+		// drain once more before acting on them
+		const int closeStreamId = m_closeStreamId.exchange(0);
+		const bool running = isThreadRunning();
+		if (closeStreamId == 0 && running) {
+			sleep(2);
+			continue;
+		}
+		while (m_queued.pop(index)) {
+			write(m_jobs[index]);
+			m_free.push(index);
+		}
+		if (closeStreamId == m_openStreamId)
+			closeStream();
+		if (!running)
+			break;
+	}
+	closeStream();
+}
+
+void GeometryExporter::write(Job& job)
+{
+	// swapped, not copied: the job gets the old ones' storage to fill next time
+	if (job.newIndices)
+		m_indices.swap(job.indices);
+	if (!job.snapshotPath.empty())
+		writeSnapshot(job);
+	if (job.streamId != 0)
+		writeStreamFrame(job);
+	m_writtenFrames++;
+}
+
+void GeometryExporter::writeSnapshot(const Job& job)
+{
+	m_scratch.clear();
+	const uint32_t numVertices = uint32_t(job.vertices.size());
+	const int corners = collectPrimitives(m_indices, job.mode, numVertices, m_scratch);
+
+	std::FILE* file = std::fopen(job.snapshotPath.c_str(), "wb");
+	if (!file) {
+		ofLogError("GeometryExporter") << "can't write " << job.snapshotPath;
+		return;
+	}
+
+	// glm::vec3 is three packed floats and the hosts the apps run on are little-endian
+	std::string header = "ply\nformat binary_little_endian 1.0\ncomment ofxRealSenseTools\n";
+	header += "element vertex " + ofToString(numVertices) + "\nproperty float x\nproperty float y\nproperty float z\n";
+	if (corners == 3)
+		header += "element face " + ofToString(m_scratch.size() / 3) + "\nproperty list uchar uint vertex_indices\n";
+	else if (corners == 2)
+		header += "element edge " + ofToString(m_scratch.size() / 2) + "\nproperty int vertex1\nproperty int vertex2\n";
+	header += "end_header\n";
+
+	size_t written = std::fwrite(header.data(), 1, header.size(), file);
+	written += std::fwrite(job.vertices.data(), sizeof(glm::vec3), numVertices, file) * sizeof(glm::vec3);
+	size_t expected = header.size() + numVertices * sizeof(glm::vec3);
+	if (corners == 3) {
+		// a face is a uchar corner count and then the corners
+		std::vector<uint8_t> faces(m_scratch.size() / 3 * 13);
+		for (size_t i = 0, f = 0; i < m_scratch.size(); i += 3, f += 13) {
+			faces[f] = 3;
+			std::memcpy(&faces[f + 1], &m_scratch[i], 3 * sizeof(uint32_t));
+		}
+		written += std::fwrite(faces.data(), 1, faces.size(), file);
+		expected += faces.size();
+	}
+	else if (corners == 2) {
+		written += std::fwrite(m_scratch.data(), sizeof(uint32_t), m_scratch.size(), file) * sizeof(uint32_t);
+		expected += m_scratch.size() * sizeof(uint32_t);
+	}
+	std::fclose(file);
+	m_bytesWritten += written;
+
+	if (written != expected)
+		ofLogError("GeometryExporter") << "can't write " << job.snapshotPath;
+	else
+		ofLogNotice("GeometryExporter") << "wrote " << numVertices << " vertices to " << job.snapshotPath;
+}
+
+void GeometryExporter::writeStreamFrame(const Job& job)
+{
+	if (job.streamId != m_openStreamId) {
+		closeStream();
+		m_openStreamId = job.streamId;
+		m_streamHasIndices = false;
+		m_stream = std::fopen(job.streamPath.c_str(), "wb");
+		if (!m_stream) {
+			ofLogError("GeometryExporter") << "can't write " << job.streamPath;
+			return;
+		}
+		std::fwrite(streamMagic, 1, sizeof(streamMagic), m_stream);
+		std::fwrite(&streamVersion, sizeof(streamVersion), 1, m_stream);
+		m_bytesWritten += sizeof(streamMagic) + sizeof(streamVersion);
+	}
+	if (!m_stream)
+		return;
+
+	// the stream's first frame with indices carries them even if they didn't change
+	const bool withIndices = job.mode != OF_PRIMITIVE_POINTS && (job.newIndices || !m_streamHasIndices);
+	StreamFrameHeader header = {};
+	std::memcpy(header.magic, frameMagic, sizeof(frameMagic));
+	header.flags = withIndices ? indicesFlag : 0;
+	header.numVertices = uint32_t(job.vertices.size());
+	header.numIndices = withIndices ? uint32_t(m_indices.size()) : 0;
+	header.mode = uint32_t(job.mode);
+	header.frame = job.frame;
+
+	size_t written = std::fwrite(&header, sizeof(header), 1, m_stream) * sizeof(header);
+	written += std::fwrite(job.vertices.data(), sizeof(glm::vec3), job.vertices.size(), m_stream) * sizeof(glm::vec3);
+	size_t expected = sizeof(header) + job.vertices.size() * sizeof(glm::vec3);
+	if (withIndices) {
+		m_scratch.assign(m_indices.begin(), m_indices.end()); // ofIndexType is 16 bit on GLES
+		written += std::fwrite(m_scratch.data(), sizeof(uint32_t), m_scratch.size(), m_stream) * sizeof(uint32_t);
+		expected += m_scratch.size() * sizeof(uint32_t);
+		m_streamHasIndices = true;
+	}
+	m_bytesWritten += written;
+
+	if (written != expected) {
+		ofLogError("GeometryExporter") << "can't write to " << job.streamPath << ", stream stopped";
+		closeStream();
+	}
+}
+
+void GeometryExporter::closeStream()
+{
+	if (m_stream)
+		std::fclose(m_stream);
+	m_stream = nullptr;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "ofMain.h"
+#include "spscQueue.h"
+#include <cstdio>
+
+// Writes the geometry the apps build out for offline tools, on its own thread:
+// a snapshot of one frame as binary little-endian PLY, or every frame to a
+// point stream (.pstream):
+//
+//   Header  magic "RSPOINTS", version
+//   Frame   magic "FRME", flags (indices follow), vertex count, index count,
+//           primitive mode, frame number (dropped ones leave gaps),
+//           x y z floats, uint32 indices
+//
+// A stream frame only carries indices when they changed since the frame
+// before; otherwise the previous ones still apply. submit() takes the arrays
+// into one of a fixed set of buffers, which travel to the writer and back
+// through lock-free queues, so the render loop never allocates or waits on the
+// disk for it. When every buffer is still queued the frame is dropped (and
+// counted).
+class GeometryExporter : public ofThread
+{
+
+public:
+	explicit GeometryExporter(int numBuffers = 4);
+	~GeometryExporter();
+
+	// Writes the next submitted frame to path, relative to the data folder.
+	void requestSnapshot(const std::string& path);
+	// Appends every submitted frame to the stream at path until stopStream().
+	void startStream(const std::string& path);
+	void stopStream();
+	bool isStreaming() const { return m_streaming; }
+	// Writes what is still queued, closes the stream and ends the thread.
+	void stop();
+
+	// Main thread, once a frame's geometry is built: the first numVertices
+	// vertices, and the indices they are drawn with in mode (not taken for
+	// OF_PRIMITIVE_POINTS). indicesVersion has to change whenever the indices
+	// do, see GridMesh::getIndicesVersion(); unchanged indices are not taken
+	// again. Does nothing unless a snapshot or a stream wants the frame.
+	void submit(const std::vector<glm::vec3>& vertices, int numVertices,
+		const std::vector<ofIndexType>& indices, uint64_t indicesVersion, ofPrimitiveMode mode);
+
+	uint64_t getWrittenFrames() const { return m_writtenFrames; }
+	uint64_t getDroppedFrames() const { return m_droppedFrames; }
+	uint64_t getBytesWritten() const { return m_bytesWritten; }
+	// "off", or the stream's path, frames written and dropped
+	std::string getSummary() const;
+
+protected:
+	void threadedFunction() override;
+
+private:
+	struct Job
+	{
+		std::vector<glm::vec3> vertices;
+		std::vector<ofIndexType> indices;
+		bool newIndices = false; // indices holds them, otherwise the last ones apply
+		ofPrimitiveMode mode = OF_PRIMITIVE_POINTS;
+		uint64_t frame = 0;
+		std::string snapshotPath; // empty for none
+		int streamId = 0;         // 0 for none
+		std::string streamPath;
+	};
+
+	void ensureThread();
+	void write(Job& job);
+	void writeSnapshot(const Job& job);
+	void writeStreamFrame(const Job& job);
+	void closeStream();
+
+	std::vector<Job> m_jobs;
+	SpscQueue<int> m_free;   // jobs submit() may fill, handed back by the writer
+	SpscQueue<int> m_queued; // jobs waiting for the writer
+
+	// main thread
+	std::string m_snapshotPath;
+	std::string m_streamPath;     // as given, for getSummary()
+	std::string m_streamDataPath; // in the data folder
+	bool m_streaming = false;
+	int m_streamId = 0;
+	uint64_t m_submittedFrames = 0;
+	uint64_t m_takenIndicesVersion = 0;
+	bool m_hasTakenIndices = false;
+
+	// writer thread
+	std::vector<ofIndexType> m_indices; // the ones that currently apply
+	std::vector<uint32_t> m_scratch;
+	std::FILE* m_stream = nullptr;
+	int m_openStreamId = 0;
+	bool m_streamHasIndices = false;
+
+	std::atomic<int> m_closeStreamId{ 0 }; // main to writer
+	std::atomic<uint64_t> m_writtenFrames{ 0 };
+	std::atomic<uint64_t> m_droppedFrames{ 0 };
+	std::atomic<uint64_t> m_bytesWritten{ 0 };
+};
@@ -0,0 +1,100 @@
+#include "gridIndexBuffer.h"
+#include "gridMesh.h"
+
+bool GridIndexBuffer::update(int columns, int rows, ofPrimitiveMode mode)
+{
+	if (m_built && columns == m_columns && rows == m_rows && mode == m_mode)
+		return false;
+
+	m_columns = columns;
+	m_rows = rows;
+	m_mode = mode;
+	m_built = true;
+	build();
+	return true;
+}
+
+void GridIndexBuffer::build()
+{
+	const int columns = m_columns;
+	const int rows = m_rows;
+	auto vertex = [columns](int x, int y) { return static_cast<ofIndexType>(x + y * columns); };
+
+	m_indices.clear();
+	switch (m_mode) {
+	case OF_PRIMITIVE_TRIANGLES:
+		// two triangles per grid cell
+		m_indices.reserve(std::max(0, (columns - 1) * (rows - 1) * 6));
+		for (int y = 0; y + 1 < rows; y++) {
+			for (int x = 0; x + 1 < columns; x++) {
+				m_indices.push_back(vertex(x, y));
+				m_indices.push_back(vertex(x + 1, y));
+				m_indices.push_back(vertex(x, y + 1));
+
+				m_indices.push_back(vertex(x + 1, y));
+				m_indices.push_back(vertex(x + 1, y + 1));
+				m_indices.push_back(vertex(x, y + 1));
+			}
+		}
+		break;
+
+	case OF_PRIMITIVE_TRIANGLE_STRIP:
+		// one strip zig-zagging down each pair of rows
+		m_indices.reserve(std::max(0, (rows - 1) * (columns * 2 + 1)));
+		for (int y = 0; y + 1 < rows; y++) {
+			for (int x = 0; x < columns; x++) {
+				m_indices.push_back(vertex(x, y));
+				m_indices.push_back(vertex(x, y + 1));
+			}
+			m_indices.push_back(GridMesh::restartIndex);
+		}
+		break;
+
+	case OF_PRIMITIVE_TRIANGLE_FAN:
+		// one fan per grid cell
+		m_indices.reserve(std::max(0, (columns - 1) * (rows - 1) * 5));
+		for (int y = 0; y + 1 < rows; y++) {
+			for (int x = 0; x + 1 < columns; x++) {
+				m_indices.push_back(vertex(x, y));
+				m_indices.push_back(vertex(x + 1, y));
+				m_indices.push_back(vertex(x + 1, y + 1));
+				m_indices.push_back(vertex(x, y + 1));
+				m_indices.push_back(GridMesh::restartIndex);
+			}
+		}
+		break;
+
+	case OF_PRIMITIVE_LINES:
+		// every horizontal and vertical grid edge
+		for (int y = 0; y < rows; y++) {
+			for (int x = 0; x < columns; x++) {
+				if (x + 1 < columns) {
+					m_indices.push_back(vertex(x, y));
+					m_indices.push_back(vertex(x + 1, y));
+				}
+				if (y + 1 < rows) {
+					m_indices.push_back(vertex(x, y));
+					m_indices.push_back(vertex(x, y + 1));
+				}
+			}
+		}
+		break;
+
+	case OF_PRIMITIVE_LINE_STRIP:
+	case OF_PRIMITIVE_LINE_LOOP:
+		// one strip (or loop) per row
+		m_indices.reserve(rows * (columns + 1));
+		for (int y = 0; y < rows; y++) {
+			for (int x = 0; x < columns; x++)
+				m_indices.push_back(vertex(x, y));
+			m_indices.push_back(GridMesh::restartIndex);
+		}
+		break;
+
+	default:
+		m_indices.reserve(columns * rows);
+		for (int i = 0; i < columns * rows; i++)
+			m_indices.push_back(static_cast<ofIndexType>(i));
+		break;
+	}
+}
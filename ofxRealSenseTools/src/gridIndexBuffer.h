@@ -0,0 +1,25 @@
+#pragma once
+#include "ofMain.h"
+
+// Index buffer for a columns x rows vertex grid (row major, one vertex per
+// sample), cached by (columns, rows, primitive mode) so it is only rebuilt when
+// stepSize or the primitive mode changes. Strip, loop and fan layouts are cut
+// into pieces with GridMesh::restartIndex.
+class GridIndexBuffer
+{
+
+public:
+	// Returns true if the indices had to be regenerated.
+	bool update(int columns, int rows, ofPrimitiveMode mode);
+
+	const std::vector<ofIndexType>& getIndices() const { return m_indices; }
+
+private:
+	void build();
+
+	std::vector<ofIndexType> m_indices;
+	int m_columns = 0;
+	int m_rows = 0;
+	ofPrimitiveMode m_mode = OF_PRIMITIVE_TRIANGLES;
+	bool m_built = false;
+};
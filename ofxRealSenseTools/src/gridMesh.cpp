@@ -0,0 +1,128 @@
+#include "gridMesh.h"
+#include "dirtyTiles.h"
+
+const ofIndexType GridMesh::restartIndex;
+
+bool GridMesh::allocate(int columns, int rows)
+{
+	if (columns == m_columns && rows == m_rows)
+		return false;
+
+	m_columns = columns;
+	m_rows = rows;
+	m_vertices.assign(columns * rows, glm::vec3(0, 0, 0));
+	m_indices.clear();
+	m_numVertices = 0;
+	m_reallocate = true;
+	m_colorChanged = m_hasColor;
+	m_verticesToUpload = 0;
+	m_vertexRanges.clear();
+	m_indicesChanged = true;
+	return true;
+}
+
+void GridMesh::setColor(const ofFloatColor& color)
+{
+	m_color = color;
+	m_hasColor = true;
+	m_colorChanged = true;
+}
+
+void GridMesh::updateVertices(int count)
+{
+	m_numVertices = count;
+	m_verticesToUpload = std::max(m_verticesToUpload, count);
+}
+
+void GridMesh::updateVertices(const DirtyTiles& tiles)
+{
+	if (tiles.isAllDirty()) {
+		updateVertices(m_columns * m_rows);
+		return;
+	}
+	// spans come in memory order, so adjacent ones (whole tile rows) merge
+	tiles.forEachDirtySpan([&](int row, int firstColumn, int endColumn) {
+		const int first = row * m_columns + firstColumn;
+		const int count = endColumn - firstColumn;
+		if (!m_vertexRanges.empty() && m_vertexRanges.back().first + m_vertexRanges.back().second == first)
+			m_vertexRanges.back().second += count;
+		else
+			m_vertexRanges.emplace_back(first, count);
+	});
+
+	// more ranges than one frame can produce: frames were built without being
+	// drawn (headless), so upload everything once instead
+	if (m_vertexRanges.size() > size_t(m_rows * tiles.getTileColumns())) {
+		m_vertexRanges.clear();
+		m_verticesToUpload = m_columns * m_rows;
+	}
+}
+
+void GridMesh::updateIndices()
+{
+	m_indicesChanged = true;
+	m_indicesVersion++;
+}
+
+void GridMesh::upload()
+{
+	if (m_reallocate) {
+		m_vbo.clear();
+		m_vbo.setVertexData(m_vertices.data(), m_vertices.size(), GL_DYNAMIC_DRAW);
+		m_indexCapacity = 0;
+		m_reallocate = false;
+		m_verticesToUpload = 0;
+		m_vertexRanges.clear();
+	}
+	if (m_colorChanged) {
+		std::vector<ofFloatColor> colors(m_vertices.size(), m_color);
+		m_vbo.setColorData(colors.data(), colors.size(), GL_STATIC_DRAW);
+		m_colorChanged = false;
+	}
+	if (m_verticesToUpload > 0) {
+		m_vbo.updateVertexData(m_vertices.data(), m_verticesToUpload);
+	}
+	for (const auto& range : m_vertexRanges) {
+		// skip what the full upload above already covered
+		const int first = std::max(range.first, m_verticesToUpload);
+		const int end = range.first + range.second;
+		if (first < end)
+			m_vbo.getVertexBuffer().updateData(first * sizeof(glm::vec3), (end - first) * sizeof(glm::vec3), &m_vertices[first]);
+	}
+	m_verticesToUpload = 0;
+	m_vertexRanges.clear();
+	if (m_indicesChanged) {
+		const int numIndices = m_indices.size();
+		if (numIndices > m_indexCapacity) {
+			m_vbo.setIndexData(m_indices.data(), numIndices, GL_DYNAMIC_DRAW);
+			m_indexCapacity = numIndices;
+		}
+		else if (numIndices > 0) {
+			m_vbo.updateIndexData(m_indices.data(), numIndices);
+		}
+		m_indicesChanged = false;
+	}
+}
+
+void GridMesh::draw(ofPrimitiveMode mode)
+{
+	draw(mode, 0, m_numVertices);
+}
+
+void GridMesh::draw(ofPrimitiveMode mode, int first, int count)
+{
+	upload();
+	if (count > 0)
+		m_vbo.draw(ofGetGLPrimitiveMode(mode), first, count);
+}
+
+void GridMesh::drawElements(ofPrimitiveMode mode)
+{
+	upload();
+	if (m_indices.empty())
+		return;
+	glEnable(GL_PRIMITIVE_RESTART);
+	glPrimitiveRestartIndex(restartIndex);
+	m_vbo.drawElements(ofGetGLPrimitiveMode(mode), m_indices.size());
+	glDisable(GL_PRIMITIVE_RESTART);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "ofMain.h"
+#include <limits>
+
+class DirtyTiles;
+
+// Vertex storage for a depth sampling grid that lives across frames.
+// CPU and GPU buffers are only (re)allocated when the grid shape changes;
+// every other frame the positions are overwritten in place and only the
+// position attribute is re-uploaded. GL work is deferred to draw(), so the
+// geometry can also be built without a GL context.
+class GridMesh
+{
+
+public:
+	// Sizes the mesh for columns x rows vertices. Returns false, and keeps all
+	// current contents, if the shape did not change.
+	bool allocate(int columns, int rows);
+	// Constant colour for every vertex, uploaded once.
+	void setColor(const ofFloatColor& color);
+	bool hasColor() const { return m_hasColor; }
+
+	int getColumns() const { return m_columns; }
+	int getRows() const { return m_rows; }
+
+	std::vector<glm::vec3>& getVertices() { return m_vertices; }
+	const std::vector<glm::vec3>& getVertices() const { return m_vertices; }
+	// Number of vertices written by the last updateVertices() call.
+	int getNumVertices() const { return m_numVertices; }
+
+	// The first count vertices were rewritten: upload them and draw that many.
+	void updateVertices(int count);
+	// Only the vertices of the dirty tiles were rewritten (one vertex per
+	// sample, row after row): upload just those, as few ranges as possible.
+	// The number of vertices drawn stays the same.
+	void updateVertices(const DirtyTiles& tiles);
+
+	// Index value that ends the current primitive and starts a new one, so that
+	// several strips or loops can share one buffer and one draw call.
+	static const ofIndexType restartIndex = std::numeric_limits<ofIndexType>::max();
+
+	std::vector<ofIndexType>& getIndices() { return m_indices; }
+	const std::vector<ofIndexType>& getIndices() const { return m_indices; }
+	// The index array was rewritten and needs to be re-uploaded.
+	void updateIndices();
+	// Changes with every updateIndices() call.
+	uint64_t getIndicesVersion() const { return m_indicesVersion; }
+
+	// Performs the pending GL uploads. draw() does this itself; calling it first
+	// lets the upload be timed apart from the draw.
+	void upload();
+
+	void draw(ofPrimitiveMode mode);
+	void draw(ofPrimitiveMode mode, int first, int count);
+	// Strips are separated by restartIndex, so this needs a GL 3.1 context.
+	void drawElements(ofPrimitiveMode mode);
+
+private:
+	ofVbo m_vbo;
+	std::vector<glm::vec3> m_vertices;
+	std::vector<ofIndexType> m_indices;
+	ofFloatColor m_color;
+	int m_columns = 0;
+	int m_rows = 0;
+	int m_numVertices = 0;
+
+	bool m_reallocate = false;
+	bool m_hasColor = false;
+	bool m_colorChanged = false;
+	int m_verticesToUpload = 0;
+	std::vector<std::pair<int, int>> m_vertexRanges; // (first, count) to upload besides m_verticesToUpload
+	bool m_indicesChanged = false;
+	uint64_t m_indicesVersion = 0;
+	int m_indexCapacity = 0;
+};
@@ -0,0 +1,225 @@
+#include "holeFilling.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HOLE_FILLING_SSE2 1
+#endif
+
+namespace {
+	// Index of the first sample at or after start that is below minValid, or end.
+	int findInvalid(const float* values, int start, int end, float minValid)
+	{
+		int i = start;
+#ifdef HOLE_FILLING_SSE2
+		const __m128 threshold = _mm_set1_ps(minValid);
+		for (; i + 4 <= end; i += 4) {
+			const int mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(values + i), threshold));
+			if (mask != 0)
+				break;
+		}
+#endif
+		while (i < end && !(values[i] < minValid))
+			i++;
+		return i;
+	}
+
+	// Index of the first sample at or after start that is not below minValid, or end.
+	int findValid(const float* values, int start, int end, float minValid)
+	{
+		int i = start;
+#ifdef HOLE_FILLING_SSE2
+		const __m128 threshold = _mm_set1_ps(minValid);
+		for (; i + 4 <= end; i += 4) {
+			const int mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(values + i), threshold));
+			if (mask != 0xF)
+				break;
+		}
+#endif
+		while (i < end && values[i] < minValid)
+			i++;
+		return i;
+	}
+
+	// dst[i] = a[i] + (b[i] - a[i]) * t
+	void lerpRow(float* dst, const float* a, const float* b, float t, int count)
+	{
+		int i = 0;
+#ifdef HOLE_FILLING_SSE2
+		const __m128 weight = _mm_set1_ps(t);
+		for (; i + 4 <= count; i += 4) {
+			const __m128 va = _mm_loadu_ps(a + i);
+			const __m128 vb = _mm_loadu_ps(b + i);
+			_mm_storeu_ps(dst + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), weight)));
+		}
+#endif
+		for (; i < count; i++)
+			dst[i] = a[i] + (b[i] - a[i]) * t;
+	}
+
+	// Fills the gaps of one row. Returns false if the row has no valid sample.
+	bool fillRow(float* row, int columns, float minValid)
+	{
+		int gapStart = findInvalid(row, 0, columns, minValid);
+		if (gapStart == columns)
+			return true;
+
+		while (gapStart < columns) {
+			const int gapEnd = findValid(row, gapStart, columns, minValid);
+			const bool hasLeft = gapStart > 0;
+			const bool hasRight = gapEnd < columns;
+			if (!hasLeft && !hasRight)
+				return false;
+
+			if (hasLeft && hasRight) {
+				const float left = row[gapStart - 1];
+				const float right = row[gapEnd];
+				const float step = (right - left) / (gapEnd - gapStart + 1);
+				for (int i = gapStart; i < gapEnd; i++)
+					row[i] = left + step * (i - gapStart + 1);
+			}
+			else {
+				const float edge = hasLeft ? row[gapStart - 1] : row[gapEnd];
+				std::fill(row + gapStart, row + gapEnd, edge);
+			}
+			gapStart = findInvalid(row, gapEnd, columns, minValid);
+		}
+		return true;
+	}
+
+	// Per-column state of the sweep in fillDepthHoles(), reused across calls.
+	struct ColumnScratch
+	{
+		std::vector<int> above; // row of the nearest valid sample above, or -1
+		std::vector<int> below; // row of the nearest valid sample below, or rows
+	};
+
+	ColumnScratch& getColumnScratch(int columns)
+	{
+		thread_local ColumnScratch scratch;
+		if (int(scratch.above.size()) < columns) {
+			scratch.above.resize(columns);
+			scratch.below.resize(columns);
+		}
+		return scratch;
+	}
+
+	// Fills what the blended pass left: samples whose whole row and column were
+	// invalid. Rows are filled along themselves first, after which every row is
+	// either complete or has no valid samples at all, and those are filled from
+	// the complete rows above and below, a whole row at a time.
+	void fillRemainingRows(float* grid, int columns, int rows, float minValid, float fallback)
+	{
+		int lastFilledRow = -1;
+		for (int y = 0; y < rows; y++) {
+			float* row = grid + y * columns;
+			if (!fillRow(row, columns, minValid))
+				continue;
+
+			if (y - lastFilledRow > 1) {
+				if (lastFilledRow < 0) {
+					for (int gap = 0; gap < y; gap++)
+						std::copy(row, row + columns, grid + gap * columns);
+				}
+				else {
+					const float* above = grid + lastFilledRow * columns;
+					const int span = y - lastFilledRow;
+					for (int gap = lastFilledRow + 1; gap < y; gap++)
+						lerpRow(grid + gap * columns, above, row, float(gap - lastFilledRow) / span, columns);
+				}
+			}
+			lastFilledRow = y;
+		}
+
+		if (lastFilledRow < 0) {
+			std::fill(grid, grid + columns * rows, fallback);
+			return;
+		}
+		const float* last = grid + lastFilledRow * columns;
+		for (int gap = lastFilledRow + 1; gap < rows; gap++)
+			std::copy(last, last + columns, grid + gap * columns);
+	}
+}
+
+void fillDepthHoles(float* grid, int columns, int rows, float minValid, float fallback)
+{
+	if (columns <= 0 || rows <= 0)
+		return;
+
+	// One sweep down the rows. Each column keeps the nearest valid sample above
+	// the current row and, found lazily, the nearest one below, so finding them
+	// costs one walk down every column in total. Valid samples are never
+	// written and the rows below the current one are still untouched, so both
+	// passes only ever see the original valid samples.
+	auto& scratch = getColumnScratch(columns);
+	std::fill(scratch.above.begin(), scratch.above.begin() + columns, -1);
+	std::fill(scratch.below.begin(), scratch.below.begin() + columns, 0);
+	bool unfilled = false;
+
+	for (int y = 0; y < rows; y++) {
+		float* row = grid + y * columns;
+		int validStart = 0;
+		int gapStart = findInvalid(row, 0, columns, minValid);
+		while (true) {
+			std::fill(scratch.above.begin() + validStart, scratch.above.begin() + gapStart, y);
+			if (gapStart == columns)
+				break;
+
+			const int gapEnd = findValid(row, gapStart, columns, minValid);
+			const bool hasLeft = gapStart > 0;
+			const bool hasRight = gapEnd < columns;
+			const float left = hasLeft ? row[gapStart - 1] : 0;
+			const float right = hasRight ? row[gapEnd] : 0;
+			for (int x = gapStart; x < gapEnd; x++) {
+				// horizontal: linear across the gap, or the one valid side
+				float horizontal = 0;
+				int horizontalDistance = 0; // to the nearest valid sample, 0 for none
+				if (hasLeft && hasRight) {
+					horizontal = left + (right - left) * (x - gapStart + 1) / (gapEnd - gapStart + 1);
+					horizontalDistance = std::min(x - gapStart + 1, gapEnd - x);
+				}
+				else if (hasLeft || hasRight) {
+					horizontal = hasLeft ? left : right;
+					horizontalDistance = hasLeft ? x - gapStart + 1 : gapEnd - x;
+				}
+
+				// vertical, the same down the column
+				const int above = scratch.above[x];
+				int& below = scratch.below[x];
+				if (below <= y) {
+					below = y + 1;
+					while (below < rows && grid[below * columns + x] < minValid)
+						below++;
+				}
+				float vertical = 0;
+				int verticalDistance = 0;
+				if (above >= 0 && below < rows) {
+					const float top = grid[above * columns + x];
+					const float bottom = grid[below * columns + x];
+					vertical = top + (bottom - top) * (y - above) / (below - above);
+					verticalDistance = std::min(y - above, below - y);
+				}
+				else if (above >= 0 || below < rows) {
+					vertical = grid[(above >= 0 ? above : below) * columns + x];
+					verticalDistance = above >= 0 ? y - above : below - y;
+				}
+
+				// blended by inverse distance, so the nearer span dominates
+				if (horizontalDistance > 0 && verticalDistance > 0)
+					row[x] = (horizontal * verticalDistance + vertical * horizontalDistance) / (horizontalDistance + verticalDistance);
+				else if (horizontalDistance > 0)
+					row[x] = horizontal;
+				else if (verticalDistance > 0)
+					row[x] = vertical;
+				else
+					unfilled = true;
+			}
+			validStart = gapEnd;
+			gapStart = findInvalid(row, gapEnd, columns, minValid);
+		}
+	}
+
+	if (unfilled)
+		fillRemainingRows(grid, columns, rows, minValid, fallback);
+}
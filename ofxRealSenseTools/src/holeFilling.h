@@ -0,0 +1,12 @@
+#pragma once
+
+// Fills the invalid samples (z < minValid) of a columns x rows depth grid in
+// place from the valid ones. Each invalid sample is interpolated linearly
+// between the nearest valid samples on either side in its row, and the same in
+// its column (or copies the one valid side at the edges). The two are blended
+// by inverse distance, so the nearer span dominates. Samples whose row and
+// column both have no valid samples are then filled along the rows the passes
+// filled, or from the complete rows above and below. The sweep finds every
+// neighbour in one walk along each row and column, so the cost stays linear in
+// the grid size. If the grid has no valid samples it is set to fallback.
+void fillDepthHoles(float* grid, int columns, int rows, float minValid, float fallback);
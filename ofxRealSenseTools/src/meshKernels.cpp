@@ -0,0 +1,293 @@
+#include "meshKernels.h"
+#include "dirtyTiles.h"
+
+namespace {
+	// Rows per parallel task: a few tasks per thread so uneven rows balance out,
+	// but never so few rows that handing out tasks costs more than the work.
+	int rowsPerBand(const WorkerPool& pool, int rows)
+	{
+		return std::max(4, rows / (pool.getNumThreads() * 4));
+	}
+
+	// Calls body(firstRow, endRow) for row bands covering rows, on the pool if there is one.
+	template <typename Body>
+	void forEachBand(WorkerPool* pool, int rows, Body body)
+	{
+		if (!pool) {
+			body(0, rows);
+			return;
+		}
+		const int bandRows = rowsPerBand(*pool, rows);
+		const int numBands = (rows + bandRows - 1) / bandRows;
+		pool->parallelFor(numBands, [&](int band) {
+			body(band * bandRows, std::min(rows, (band + 1) * bandRows));
+		});
+	}
+
+	// Calls body(row, firstColumn, endColumn) for every dirty span of tiles, a
+	// tile row per task on the pool if there is one.
+	template <typename Body>
+	void forEachDirtySpan(WorkerPool* pool, const DirtyTiles& tiles, Body body)
+	{
+		if (!pool) {
+			tiles.forEachDirtySpan(body);
+			return;
+		}
+		pool->parallelFor(tiles.getTileRows(), [&](int tileRow) {
+			tiles.forEachDirtySpan(tileRow, body);
+		});
+	}
+
+	// One row of extruded z values and validity flags, per thread so parallel
+	// bands don't share it, and only ever grown.
+	struct RowScratch
+	{
+		std::vector<float> z;
+		std::vector<uint8_t> valid;
+	};
+
+	RowScratch& getRowScratch(int columns)
+	{
+		thread_local RowScratch scratch;
+		if (int(scratch.z.size()) < columns) {
+			scratch.z.resize(columns);
+			scratch.valid.resize(columns);
+		}
+		return scratch;
+	}
+
+	// Extrudes sampled columns firstColumn .. firstColumn + count - 1 of row into
+	// z, and valid if it is not null.
+	void extrudeSampledSpan(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+		int row, int firstColumn, int count, float* z, uint8_t* valid)
+	{
+		const int stride = sampling.getSampleStride();
+		extrudeDepthRow(sampling.getSampleRow(depth, row) + firstColumn * stride, count, stride, extrusion, z, valid);
+	}
+
+	// Extrudes the sampled columns of row into z, and valid if it is not null.
+	void extrudeSampledRow(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+		int row, float* z, uint8_t* valid)
+	{
+		extrudeSampledSpan(depth, extrusion, sampling, row, 0, sampling.getColumns(), z, valid);
+	}
+
+	int buildPointCloudRows(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+		bool filterNoise, glm::vec3* vertices, int firstRow, int endRow)
+	{
+		const int columns = sampling.getColumns();
+		auto& scratch = getRowScratch(columns);
+		int numVertices = 0;
+		for (int row = firstRow; row < endRow; row++) {
+			const float y = sampling.border + row * sampling.stepSize;
+			extrudeSampledRow(depth, extrusion, sampling, row, scratch.z.data(), filterNoise ? scratch.valid.data() : nullptr);
+			for (int column = 0; column < columns; column++) {
+				// ignore floor/ceiling points
+				if (!filterNoise || scratch.valid[column])
+					vertices[numVertices++] = glm::vec3(sampling.border + column * sampling.stepSize, y, scratch.z[column]);
+			}
+		}
+		return numVertices;
+	}
+
+	// Marks every invalid sample as an outlier, z = minMappedDepth - 1.
+	void markOutlierSamples(float* z, const uint8_t* valid, int count, float minMappedDepth)
+	{
+		for (int i = 0; i < count; i++) {
+			if (!valid[i])
+				z[i] = minMappedDepth - 1; // -1 to bypass any weird float comparision.
+		}
+	}
+}
+
+int buildPointCloud(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool filterNoise, glm::vec3* vertices, WorkerPool* pool)
+{
+	const int rows = sampling.getRows();
+	if (!pool)
+		return buildPointCloudRows(depth, extrusion, sampling, filterNoise, vertices, 0, rows);
+
+	// Every band writes from the start of its own rows, then the bands are
+	// moved down, in order, to close the gaps filterNoise left.
+	const int columns = sampling.getColumns();
+	const int bandRows = rowsPerBand(*pool, rows);
+	const int numBands = (rows + bandRows - 1) / bandRows;
+	std::vector<int> bandVertices(numBands);
+	pool->parallelFor(numBands, [&](int band) {
+		const int firstRow = band * bandRows;
+		bandVertices[band] = buildPointCloudRows(depth, extrusion, sampling, filterNoise,
+			vertices + firstRow * columns, firstRow, std::min(rows, firstRow + bandRows));
+	});
+
+	int numVertices = 0;
+	for (int band = 0; band < numBands; band++) {
+		const glm::vec3* bandStart = vertices + band * bandRows * columns;
+		if (bandStart != vertices + numVertices)
+			std::copy(bandStart, bandStart + bandVertices[band], vertices + numVertices);
+		numVertices += bandVertices[band];
+	}
+	return numVertices;
+}
+
+void buildScanlines(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, glm::vec3* vertices, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachBand(pool, sampling.getRows(), [&](int firstRow, int endRow) {
+		auto& scratch = getRowScratch(columns);
+		for (int row = firstRow; row < endRow; row++) {
+			extrudeSampledRow(depth, extrusion, sampling, row, scratch.z.data(), markOutliers ? scratch.valid.data() : nullptr);
+			// arbitrarilly set outlier point to `minMappedDepth - 1` as a signal it needs to be interpolated.
+			if (markOutliers)
+				markOutlierSamples(scratch.z.data(), scratch.valid.data(), columns, extrusion.minMappedDepth);
+
+			const float y = sampling.border + row * sampling.stepSize;
+			glm::vec3* scanLine = vertices + row * columns;
+			for (int column = 0; column < columns; column++)
+				scanLine[column] = glm::vec3(sampling.border + column * sampling.stepSize, y, scratch.z[column]);
+		}
+	});
+}
+
+void buildScanlines(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, glm::vec3* vertices, const DirtyTiles& tiles, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachDirtySpan(pool, tiles, [&](int row, int firstColumn, int endColumn) {
+		auto& scratch = getRowScratch(columns);
+		const int count = endColumn - firstColumn;
+		extrudeSampledSpan(depth, extrusion, sampling, row, firstColumn, count, scratch.z.data(), markOutliers ? scratch.valid.data() : nullptr);
+		if (markOutliers)
+			markOutlierSamples(scratch.z.data(), scratch.valid.data(), count, extrusion.minMappedDepth);
+
+		const float y = sampling.border + row * sampling.stepSize;
+		glm::vec3* span = vertices + row * columns + firstColumn;
+		for (int i = 0; i < count; i++)
+			span[i] = glm::vec3(sampling.border + (firstColumn + i) * sampling.stepSize, y, scratch.z[i]);
+	});
+}
+
+void smoothScanline(glm::vec3* scanLine, int columns, float minMappedDepth)
+{
+	if (columns < 2)
+		return;
+	for (int i = 0; i < columns; i++) {
+		auto& targetVert = scanLine[i];
+		if (targetVert.z >= minMappedDepth)
+			continue;
+		const bool hasPrevVert = i != 0;
+		const bool hasNextVert = i != columns - 1;
+		if (hasPrevVert && hasNextVert)
+			targetVert.z = ofLerp(scanLine[i - 1].z, scanLine[i + 1].z, 0.5);
+		else if (hasPrevVert)
+			targetVert.z = scanLine[i - 1].z;
+		else
+			targetVert.z = scanLine[i + 1].z;
+	}
+}
+
+void smoothScanlines(glm::vec3* vertices, int columns, int rows, float minMappedDepth, WorkerPool* pool)
+{
+	forEachBand(pool, rows, [&](int firstRow, int endRow) {
+		for (int row = firstRow; row < endRow; row++)
+			smoothScanline(vertices + row * columns, columns, minMappedDepth);
+	});
+}
+
+void smoothScanlines(glm::vec3* vertices, int columns, float minMappedDepth, const DirtyTiles& tiles, WorkerPool* pool)
+{
+	forEachDirtySpan(pool, tiles, [&](int row, int firstColumn, int endColumn) {
+		smoothScanline(vertices + row * columns + firstColumn, endColumn - firstColumn, minMappedDepth);
+	});
+}
+
+void sampleDepthGrid(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, float* grid, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachBand(pool, sampling.getRows(), [&](int firstRow, int endRow) {
+		auto& scratch = getRowScratch(columns);
+		for (int row = firstRow; row < endRow; row++) {
+			float* gridRow = grid + row * columns;
+			extrudeSampledRow(depth, extrusion, sampling, row, gridRow, markOutliers ? scratch.valid.data() : nullptr);
+			if (markOutliers)
+				markOutlierSamples(gridRow, scratch.valid.data(), columns, extrusion.minMappedDepth);
+		}
+	});
+}
+
+void depthGridToVertices(const float* grid, const DepthSampling& sampling, glm::vec3* vertices, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachBand(pool, sampling.getRows(), [&](int firstRow, int endRow) {
+		for (int row = firstRow; row < endRow; row++) {
+			const float y = sampling.border + row * sampling.stepSize;
+			for (int column = 0; column < columns; column++) {
+				const int i = row * columns + column;
+				vertices[i] = glm::vec3(sampling.border + column * sampling.stepSize, y, grid[i]);
+			}
+		}
+	});
+}
+
+void sampleDepthGrid(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, float* grid, const DirtyTiles& tiles, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachDirtySpan(pool, tiles, [&](int row, int firstColumn, int endColumn) {
+		auto& scratch = getRowScratch(columns);
+		const int count = endColumn - firstColumn;
+		float* span = grid + row * columns + firstColumn;
+		extrudeSampledSpan(depth, extrusion, sampling, row, firstColumn, count, span, markOutliers ? scratch.valid.data() : nullptr);
+		if (markOutliers)
+			markOutlierSamples(span, scratch.valid.data(), count, extrusion.minMappedDepth);
+	});
+}
+
+void depthGridToVertices(const float* grid, const DepthSampling& sampling, glm::vec3* vertices, const DirtyTiles& tiles, WorkerPool* pool)
+{
+	const int columns = sampling.getColumns();
+	forEachDirtySpan(pool, tiles, [&](int row, int firstColumn, int endColumn) {
+		const float y = sampling.border + row * sampling.stepSize;
+		for (int column = firstColumn; column < endColumn; column++) {
+			const int i = row * columns + column;
+			vertices[i] = glm::vec3(sampling.border + column * sampling.stepSize, y, grid[i]);
+		}
+	});
+}
+
+void markChangedGridTiles(const float* grid, const glm::vec3* vertices, DirtyTiles& tiles, WorkerPool* pool)
+{
+	const int tileSize = tiles.getTileSize();
+	const int columns = tiles.getColumns();
+	const int rows = tiles.getRows();
+	auto compareTileRow = [&](int tileRow) {
+		const int endRow = std::min(rows, (tileRow + 1) * tileSize);
+		for (int tileColumn = 0; tileColumn < tiles.getTileColumns(); tileColumn++) {
+			if (tiles.isDirty(tileColumn, tileRow))
+				continue;
+			const int endColumn = std::min(columns, (tileColumn + 1) * tileSize);
+			bool tileChanged = false;
+			for (int row = tileRow * tileSize; row < endRow && !tileChanged; row++) {
+				for (int column = tileColumn * tileSize; column < endColumn; column++) {
+					const int i = row * columns + column;
+					if (vertices[i].z != grid[i]) {
+						tileChanged = true;
+						break;
+					}
+				}
+			}
+			if (tileChanged)
+				tiles.requestDirty(tileColumn, tileRow);
+		}
+	};
+	if (pool)
+		pool->parallelFor(tiles.getTileRows(), compareTileRow);
+	else {
+		for (int tileRow = 0; tileRow < tiles.getTileRows(); tileRow++)
+			compareTileRow(tileRow);
+	}
+
+	// marking updates the tile counts, so it happens on this thread
+	tiles.applyDirtyRequests();
+}
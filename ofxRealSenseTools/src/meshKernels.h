@@ -0,0 +1,78 @@
+#pragma once
+#include "ofMain.h"
+#include "depthExtrusion.h"
+#include "depthView.h"
+#include "workerPool.h"
+
+class DirtyTiles;
+
+// The per-frame depth-to-geometry loops of the apps, pulled out of
+// ofApp::update() so they can be benchmarked without a window or camera.
+// Samples are converted a whole row at a time with extrudeDepthRow(), on the
+// best SIMD path the CPU has.
+// Given a WorkerPool the rows are split into bands that are built in parallel,
+// each writing its own disjoint range of the output; the result is identical
+// to the serial one.
+// The overloads taking DirtyTiles only touch the dirty tiles of the sampling
+// grid and leave the rest of the output as it was.
+
+// The part of a depth frame that is sampled: every stepSize pixels in both
+// directions, skipping border pixels along each edge.
+struct DepthSampling
+{
+	int width = 0;
+	int height = 0;
+	int stepSize = 1;
+	int border = 0;
+	// The depth handed to the kernels already holds one value per sample, e.g.
+	// from poolDepthBlocks(), instead of the whole frame.
+	bool preSampled = false;
+
+	int getColumns() const { return (width - 2 * border + stepSize - 1) / stepSize; }
+	int getRows() const { return (height - 2 * border + stepSize - 1) / stepSize; }
+
+	// First sample of row in depth, and the distance to the next one in the row.
+	const uint16_t* getSampleRow(const DepthView& depth, int row) const
+	{
+		return preSampled ? depth.row(row) : depth.row(border + row * stepSize) + border;
+	}
+	int getSampleStride() const { return preSampled ? 1 : stepSize; }
+};
+
+// PointCloud: one vertex (x, y, extruded depth) per sample. With filterNoise,
+// samples that are not valid for extrusion are left out. Returns the number
+// of vertices written.
+int buildPointCloud(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool filterNoise, glm::vec3* vertices, WorkerPool* pool = nullptr);
+
+// AliensTopography: one vertex per sample, row after row. With markOutliers,
+// samples that are not valid for extrusion get z = minMappedDepth - 1.
+void buildScanlines(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, glm::vec3* vertices, WorkerPool* pool = nullptr);
+void buildScanlines(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, glm::vec3* vertices, const DirtyTiles& tiles, WorkerPool* pool = nullptr);
+
+// AliensTopography smoothing: each marked outlier in a scanline takes the
+// average of its (already smoothed) left and its right neighbour, or the only
+// neighbour at either end.
+void smoothScanline(glm::vec3* scanLine, int columns, float minMappedDepth);
+// smoothScanline() for each of rows scanlines of columns vertices.
+void smoothScanlines(glm::vec3* vertices, int columns, int rows, float minMappedDepth, WorkerPool* pool = nullptr);
+// smoothScanline() for the spans of the dirty tiles. Call DirtyTiles::markDirtyRows()
+// first, so that these are whole scanlines.
+void smoothScanlines(glm::vec3* vertices, int columns, float minMappedDepth, const DirtyTiles& tiles, WorkerPool* pool = nullptr);
+
+// TriangleMesh: extruded depth of every sample into a compact columns x rows
+// grid, outliers marked like buildScanlines().
+void sampleDepthGrid(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, float* grid, WorkerPool* pool = nullptr);
+void sampleDepthGrid(const DepthView& depth, const DepthExtrusion& extrusion, const DepthSampling& sampling,
+	bool markOutliers, float* grid, const DirtyTiles& tiles, WorkerPool* pool = nullptr);
+
+// TriangleMesh: grid vertices at their sample position with z from the depth grid.
+void depthGridToVertices(const float* grid, const DepthSampling& sampling, glm::vec3* vertices, WorkerPool* pool = nullptr);
+void depthGridToVertices(const float* grid, const DepthSampling& sampling, glm::vec3* vertices, const DirtyTiles& tiles, WorkerPool* pool = nullptr);
+
+// TriangleMesh: marks every tile dirty whose vertices no longer have the z of
+// the depth grid, i.e. tiles that fillDepthHoles() reached into from a dirty one.
+void markChangedGridTiles(const float* grid, const glm::vec3* vertices, DirtyTiles& tiles, WorkerPool* pool = nullptr);
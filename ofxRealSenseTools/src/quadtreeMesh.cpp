@@ -0,0 +1,182 @@
+#include "quadtreeMesh.h"
+
+const int QuadtreeMesh::maxLevel;
+
+int QuadtreeMesh::build(const float* grid, const DepthSampling& sampling, float tolerance,
+	glm::vec3* vertices, std::vector<ofIndexType>& indices)
+{
+	m_grid = grid;
+	m_sampling = sampling;
+	m_columns = sampling.getColumns();
+	m_rows = sampling.getRows();
+	m_cellColumns = std::max(0, m_columns - 1);
+	m_cellRows = std::max(0, m_rows - 1);
+	m_vertices = vertices;
+	m_numVertices = 0;
+	m_numLeaves = 0;
+	indices.clear();
+	if (m_cellColumns == 0 || m_cellRows == 0)
+		return 0;
+
+	// leaves from the error alone, one root node per 2^maxLevel square of cells
+	m_levels.assign(m_cellColumns * m_cellRows, 0);
+	const int rootSize = 1 << maxLevel;
+	for (int y = 0; y < m_cellRows; y += rootSize) {
+		for (int x = 0; x < m_cellColumns; x += rootSize)
+			subdivide(x, y, maxLevel, tolerance);
+	}
+
+	// then split until neighbouring leaves are at most one level apart; a split
+	// can unbalance coarser neighbours already visited, so repeat until stable
+	while (balance()) {}
+
+	m_vertexIndex.assign(m_columns * m_rows, -1);
+	for (int y = 0; y < m_cellRows; y++) {
+		for (int x = 0; x < m_cellColumns; x++) {
+			if (isLeaf(x, y)) {
+				triangulate(x, y, levelAt(x, y), indices);
+				m_numLeaves++;
+			}
+		}
+	}
+	return m_numVertices;
+}
+
+void QuadtreeMesh::subdivide(int x, int y, int level, float tolerance)
+{
+	if (x >= m_cellColumns || y >= m_cellRows)
+		return;
+	const int size = 1 << level;
+	// nodes sticking out of the grid are split until they fit
+	const bool inside = x + size <= m_cellColumns && y + size <= m_cellRows;
+	if (level == 0 || (inside && isFlat(x, y, size, tolerance))) {
+		setLevel(x, y, size, level);
+		return;
+	}
+	const int half = size / 2;
+	subdivide(x, y, level - 1, tolerance);
+	subdivide(x + half, y, level - 1, tolerance);
+	subdivide(x, y + half, level - 1, tolerance);
+	subdivide(x + half, y + half, level - 1, tolerance);
+}
+
+bool QuadtreeMesh::isFlat(int x, int y, int size, float tolerance) const
+{
+	auto depth = [this](int column, int row) { return m_grid[row * m_columns + column]; };
+	const float z00 = depth(x, y);
+	const float z10 = depth(x + size, y);
+	const float z01 = depth(x, y + size);
+	const float z11 = depth(x + size, y + size);
+	for (int j = 0; j <= size; j++) {
+		const float v = float(j) / size;
+		const float left = ofLerp(z00, z01, v);
+		const float right = ofLerp(z10, z11, v);
+		for (int i = 0; i <= size; i++) {
+			const float planar = ofLerp(left, right, float(i) / size);
+			if (std::abs(depth(x + i, y + j) - planar) > tolerance)
+				return false;
+		}
+	}
+	return true;
+}
+
+bool QuadtreeMesh::balance()
+{
+	bool changed = false;
+	for (int y = 0; y < m_cellRows; y++) {
+		for (int x = 0; x < m_cellColumns; x++) {
+			if (!isLeaf(x, y))
+				continue;
+			const int level = levelAt(x, y);
+			if (level < 2)
+				continue;
+			const int size = 1 << level;
+
+			// any cell along the outside of the four edges two or more levels finer?
+			bool unbalanced = false;
+			for (int i = 0; i < size && !unbalanced; i++) {
+				unbalanced =
+					(y > 0 && levelAt(x + i, y - 1) < level - 1) ||
+					(y + size < m_cellRows && levelAt(x + i, y + size) < level - 1) ||
+					(x > 0 && levelAt(x - 1, y + i) < level - 1) ||
+					(x + size < m_cellColumns && levelAt(x + size, y + i) < level - 1);
+			}
+			if (unbalanced) {
+				setLevel(x, y, size, level - 1);
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
+
+void QuadtreeMesh::setLevel(int x, int y, int size, int level)
+{
+	for (int row = y; row < y + size; row++)
+		std::fill_n(&m_levels[row * m_cellColumns + x], size, uint8_t(level));
+}
+
+bool QuadtreeMesh::isLeaf(int cellX, int cellY) const
+{
+	// a cell is the top left corner of its leaf if it is aligned to the leaf size
+	const int mask = (1 << levelAt(cellX, cellY)) - 1;
+	return (cellX & mask) == 0 && (cellY & mask) == 0;
+}
+
+ofIndexType QuadtreeMesh::vertexAt(int column, int row)
+{
+	int& index = m_vertexIndex[row * m_columns + column];
+	if (index < 0) {
+		index = m_numVertices++;
+		m_vertices[index] = glm::vec3(
+			m_sampling.border + column * m_sampling.stepSize,
+			m_sampling.border + row * m_sampling.stepSize,
+			m_grid[row * m_columns + column]);
+	}
+	return index;
+}
+
+void QuadtreeMesh::triangulate(int x, int y, int level, std::vector<ofIndexType>& indices)
+{
+	const int size = 1 << level;
+	const int half = size / 2;
+
+	// A finer neighbour has a vertex halfway along the shared edge. Balanced
+	// leaves have at most one, so checking the first cell across the edge tells.
+	const bool top = level > 0 && y > 0 && levelAt(x, y - 1) < level;
+	const bool right = level > 0 && x + size < m_cellColumns && levelAt(x + size, y) < level;
+	const bool bottom = level > 0 && y + size < m_cellRows && levelAt(x, y + size) < level;
+	const bool left = level > 0 && x > 0 && levelAt(x - 1, y) < level;
+
+	const ofIndexType topLeft = vertexAt(x, y);
+	const ofIndexType topRight = vertexAt(x + size, y);
+	const ofIndexType bottomRight = vertexAt(x + size, y + size);
+	const ofIndexType bottomLeft = vertexAt(x, y + size);
+
+	if (!top && !right && !bottom && !left) {
+		// two triangles, split like GridIndexBuffer's OF_PRIMITIVE_TRIANGLES
+		indices.insert(indices.end(), { topLeft, topRight, bottomLeft, topRight, bottomRight, bottomLeft });
+		return;
+	}
+
+	// a fan around the centre through the corners and edge midpoints, in the
+	// same winding order
+	ofIndexType outline[8];
+	int count = 0;
+	outline[count++] = topLeft;
+	if (top)
+		outline[count++] = vertexAt(x + half, y);
+	outline[count++] = topRight;
+	if (right)
+		outline[count++] = vertexAt(x + size, y + half);
+	outline[count++] = bottomRight;
+	if (bottom)
+		outline[count++] = vertexAt(x + half, y + size);
+	outline[count++] = bottomLeft;
+	if (left)
+		outline[count++] = vertexAt(x, y + half);
+
+	const ofIndexType centre = vertexAt(x + half, y + half);
+	for (int i = 0; i < count; i++)
+		indices.insert(indices.end(), { centre, outline[i], outline[(i + 1) % count] });
+}
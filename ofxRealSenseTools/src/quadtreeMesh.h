@@ -0,0 +1,49 @@
+#pragma once
+#include "ofMain.h"
+#include "meshKernels.h"
+
+// Adaptive triangulation of a depth grid as a restricted quadtree. The grid's
+// cells are covered by square leaves of up to 2^maxLevel cells; a node is only
+// split while its samples deviate from the bilinear patch through its corners
+// by more than the tolerance, so flat walls end up as a few large leaves and
+// detailed objects keep the full grid resolution. Leaves are then split until
+// no two neighbours differ by more than one level, which lets every leaf pick
+// up the one midpoint a finer neighbour puts on their shared edge: the
+// triangles meet without cracks or T-junctions.
+class QuadtreeMesh
+{
+
+public:
+	static const int maxLevel = 5; // leaves of up to 32 x 32 cells
+
+	// Triangulates the columns x rows depth grid sampled as in sampling (see
+	// sampleDepthGrid()). Writes every grid vertex used, at its sample position,
+	// to vertices (room for columns * rows) and replaces indices with
+	// OF_PRIMITIVE_TRIANGLES into them. Returns the number of vertices.
+	int build(const float* grid, const DepthSampling& sampling, float tolerance,
+		glm::vec3* vertices, std::vector<ofIndexType>& indices);
+
+	int getNumLeaves() const { return m_numLeaves; }
+
+private:
+	void subdivide(int x, int y, int level, float tolerance);
+	bool isFlat(int x, int y, int size, float tolerance) const;
+	bool balance();
+	void setLevel(int x, int y, int size, int level);
+	int levelAt(int cellX, int cellY) const { return m_levels[cellY * m_cellColumns + cellX]; }
+	bool isLeaf(int cellX, int cellY) const;
+	ofIndexType vertexAt(int column, int row);
+	void triangulate(int x, int y, int level, std::vector<ofIndexType>& indices);
+
+	const float* m_grid = nullptr;
+	DepthSampling m_sampling;
+	int m_columns = 0;
+	int m_rows = 0;
+	int m_cellColumns = 0;
+	int m_cellRows = 0;
+	std::vector<uint8_t> m_levels;  // per grid cell, level of the leaf covering it
+	std::vector<int> m_vertexIndex; // per grid vertex, its index in the output or -1
+	glm::vec3* m_vertices = nullptr;
+	int m_numVertices = 0;
+	int m_numLeaves = 0;
+};
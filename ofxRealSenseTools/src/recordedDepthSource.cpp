@@ -0,0 +1,84 @@
+#include "recordedDepthSource.h"
+#include "ofMain.h"
+#include <thread>
+
+RecordedDepthSource::RecordedDepthSource(const std::string& path, int startFrame)
+	: m_path(path), m_startFrame(std::max(0, startFrame))
+{
+}
+
+void RecordedDepthSource::start()
+{
+	if (!m_reader.open(ofToDataPath(m_path, true))) {
+		ofLogError("RecordedDepthSource") << "can't read depth recording " << m_path;
+		return;
+	}
+	// the recording's own frame rate isn't stored, the pacing comes from the timestamps
+	m_device = std::make_unique<SoftwareDepthDevice>(m_reader.getWidth(), m_reader.getHeight(), 30, m_reader.getDepthUnits());
+	m_device->start();
+	m_nextFrame = m_startFrame < m_reader.getNumFrames() ? m_startFrame : 0;
+	m_startTime = std::chrono::steady_clock::now();
+	m_playbackStart = m_startTime;
+	m_firstTimestampMs = -1; // taken from the first frame decoded
+}
+
+void RecordedDepthSource::stop()
+{
+	if (m_device)
+		m_device->stop();
+	m_device.reset();
+	m_reader.close();
+}
+
+rs2::frame RecordedDepthSource::waitForFrame(unsigned int timeoutMs)
+{
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	if (!m_device) {
+		std::this_thread::sleep_until(timeout);
+		return rs2::frame();
+	}
+
+	// decoding a frame again after a timeout is a copy, the reader keeps it
+	auto pixels = m_device->allocatePixels();
+	double timestampMs;
+	if (!m_reader.decode(m_nextFrame, pixels, timestampMs)) {
+		delete[] pixels;
+		if (m_nextFrame == 0) {
+			// starting over can't help, so from here on this only waits out the timeouts
+			ofLogError("RecordedDepthSource") << "frame 0 of " << m_path << " is corrupt, stopping playback";
+			stop();
+		}
+		else {
+			ofLogError("RecordedDepthSource") << "frame " << m_nextFrame << " of " << m_path << " is corrupt, starting over";
+			m_nextFrame = 0;
+			m_firstTimestampMs = -1;
+		}
+		std::this_thread::sleep_until(timeout);
+		return rs2::frame();
+	}
+
+	if (m_firstTimestampMs < 0) {
+		// first frame, or looped back to the start
+		m_firstTimestampMs = timestampMs;
+		m_playbackStart = std::chrono::steady_clock::now();
+	}
+	const auto due = m_playbackStart + std::chrono::microseconds(int64_t((timestampMs - m_firstTimestampMs) * 1000));
+	if (due > timeout) {
+		std::this_thread::sleep_until(timeout);
+		delete[] pixels;
+		return rs2::frame();
+	}
+	std::this_thread::sleep_until(due);
+
+	if (++m_nextFrame == m_reader.getNumFrames()) {
+		m_nextFrame = 0;
+		m_firstTimestampMs = -1;
+	}
+	// timestamps keep counting up across loops
+	return m_device->publish(pixels, std::chrono::duration<double, std::milli>(due - m_startTime).count());
+}
+
+std::string RecordedDepthSource::getDescription() const
+{
+	return "recording:" + m_path;
+}
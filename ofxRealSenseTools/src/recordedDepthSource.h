@@ -0,0 +1,31 @@
+#pragma once
+#include "depthSource.h"
+#include "depthRecording.h"
+#include "softwareDepthDevice.h"
+#include <chrono>
+
+// A depth recording (see DepthRecorder) played back at the pace it was
+// recorded at and looped. Frames are decoded straight out of the memory mapped
+// file and handed out through a SoftwareDepthDevice like synthetic ones.
+class RecordedDepthSource : public DepthSource
+{
+
+public:
+	// path relative to the data folder, playback from startFrame on
+	explicit RecordedDepthSource(const std::string& path, int startFrame = 0);
+
+	void start() override;
+	void stop() override;
+	rs2::frame waitForFrame(unsigned int timeoutMs) override;
+	std::string getDescription() const override;
+
+private:
+	std::string m_path;
+	int m_startFrame;
+	DepthRecordingReader m_reader;
+	std::unique_ptr<SoftwareDepthDevice> m_device;
+	int m_nextFrame = 0;
+	double m_firstTimestampMs = 0; // of the frame playback (re)started from
+	std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_playbackStart; // when that frame went out
+};
@@ -0,0 +1,56 @@
+#include "roundPoints.h"
+
+namespace {
+	const std::string vertexShader = R"(
+		#version 330
+		uniform mat4 modelViewProjectionMatrix;
+		uniform vec4 globalColor;
+		uniform float pointSize;
+		uniform float vertexColors;
+		in vec4 position;
+		in vec4 color;
+		out vec4 pointColor;
+		void main() {
+			pointColor = vertexColors > 0.5 ? color : globalColor;
+			gl_PointSize = pointSize;
+			gl_Position = modelViewProjectionMatrix * position;
+		}
+	)";
+
+	const std::string fragmentShader = R"(
+		#version 330
+		in vec4 pointColor;
+		out vec4 outputColor;
+		void main() {
+			// gl_PointCoord runs 0..1 across the sprite
+			if (length(gl_PointCoord - vec2(0.5)) > 0.5)
+				discard;
+			outputColor = pointColor;
+		}
+	)";
+}
+
+void RoundPoints::setup()
+{
+	m_shader.setupShaderFromSource(GL_VERTEX_SHADER, vertexShader);
+	m_shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragmentShader);
+	m_shader.bindDefaults();
+	m_shader.linkProgram();
+	m_isSetup = true;
+}
+
+void RoundPoints::begin(bool vertexColors)
+{
+	if (!m_isSetup)
+		setup();
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	m_shader.begin();
+	m_shader.setUniform1f("pointSize", m_size);
+	m_shader.setUniform1f("vertexColors", vertexColors ? 1 : 0);
+}
+
+void RoundPoints::end()
+{
+	m_shader.end();
+	glDisable(GL_PROGRAM_POINT_SIZE);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "ofMain.h"
+
+// Round points for the programmable renderer, which has no GL_POINT_SMOOTH.
+// Points drawn between begin() and end() are size pixels wide, and a small
+// shader discards the fragments of each point sprite that lie outside its
+// circle. Needs the programmable renderer (GL 3.3).
+class RoundPoints
+{
+
+public:
+	explicit RoundPoints(float size = 3) : m_size(size) {}
+
+	// vertexColors: colour the points from the mesh's colour attribute,
+	// otherwise from ofSetColor()
+	void begin(bool vertexColors);
+	void end();
+
+private:
+	void setup();
+
+	float m_size;
+	ofShader m_shader;
+	bool m_isSetup = false;
+};
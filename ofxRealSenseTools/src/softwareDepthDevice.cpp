@@ -0,0 +1,84 @@
+#include "softwareDepthDevice.h"
+
+namespace {
+	void deletePixels(void* pixels)
+	{
+		delete[] static_cast<uint16_t*>(pixels);
+	}
+}
+
+SoftwareDepthDevice::SoftwareDepthDevice(int width, int height, int fps, float depthUnits)
+	: m_width(width), m_height(height), m_fps(fps), m_depthUnits(depthUnits)
+{
+	m_sensor = std::make_unique<rs2::software_sensor>(m_device.add_sensor("Software Depth"));
+
+	// a plausible pinhole model, roughly the D400 depth field of view
+	rs2_intrinsics intrinsics = {};
+	intrinsics.width = width;
+	intrinsics.height = height;
+	intrinsics.ppx = width / 2.0f;
+	intrinsics.ppy = height / 2.0f;
+	intrinsics.fx = width * 0.75f;
+	intrinsics.fy = width * 0.75f;
+	intrinsics.model = RS2_DISTORTION_NONE;
+
+	rs2_video_stream stream = {};
+	stream.type = RS2_STREAM_DEPTH;
+	stream.index = 0;
+	stream.uid = 0;
+	stream.width = width;
+	stream.height = height;
+	stream.fps = fps > 0 ? fps : 30;
+	stream.bpp = sizeof(uint16_t);
+	stream.fmt = RS2_FORMAT_Z16;
+	stream.intrinsics = intrinsics;
+
+	m_profile = m_sensor->add_video_stream(stream);
+	m_sensor->add_read_only_option(RS2_OPTION_DEPTH_UNITS, depthUnits);
+}
+
+SoftwareDepthDevice::~SoftwareDepthDevice()
+{
+	stop();
+}
+
+void SoftwareDepthDevice::start()
+{
+	if (m_started)
+		return;
+	m_sensor->open(m_profile);
+	m_sensor->start(m_queue);
+	m_started = true;
+}
+
+void SoftwareDepthDevice::stop()
+{
+	if (!m_started)
+		return;
+	m_sensor->stop();
+	m_sensor->close();
+	m_started = false;
+}
+
+uint16_t* SoftwareDepthDevice::allocatePixels() const
+{
+	return new uint16_t[m_width * m_height];
+}
+
+rs2::frame SoftwareDepthDevice::publish(uint16_t* pixels, double timestampMs)
+{
+	rs2_software_video_frame frame = {};
+	frame.pixels = pixels;
+	frame.deleter = deletePixels;
+	frame.stride = m_width * sizeof(uint16_t);
+	frame.bpp = sizeof(uint16_t);
+	frame.timestamp = timestampMs;
+	frame.domain = RS2_TIMESTAMP_DOMAIN_SYSTEM_TIME;
+	frame.frame_number = ++m_frameNumber;
+	frame.profile = m_profile.get();
+	m_sensor->on_video_frame(frame);
+
+	rs2::frame depth;
+	m_queue.try_wait_for_frame(&depth, 1000);
+	return depth;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <librealsense2/rs.hpp>
+#include <memory>
+
+// A librealsense software device with a single Z16 depth stream. Turns depth
+// images produced in memory into real rs2::depth_frame objects, so generated
+// or decoded frames go through exactly the same code as camera frames.
+class SoftwareDepthDevice
+{
+
+public:
+	SoftwareDepthDevice(int width, int height, int fps, float depthUnits);
+	~SoftwareDepthDevice();
+
+	void start();
+	void stop();
+
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+	float getDepthUnits() const { return m_depthUnits; }
+
+	// Buffer of getWidth() * getHeight() samples to fill and pass to publish().
+	uint16_t* allocatePixels() const;
+	// Takes ownership of pixels and returns them as a depth frame.
+	rs2::frame publish(uint16_t* pixels, double timestampMs);
+
+private:
+	int m_width;
+	int m_height;
+	int m_fps;
+	float m_depthUnits;
+	int m_frameNumber = 0;
+	bool m_started = false;
+
+	rs2::software_device m_device;
+	std::unique_ptr<rs2::software_sensor> m_sensor;
+	rs2::stream_profile m_profile;
+	rs2::frame_queue m_queue;
+};
@@ -0,0 +1,98 @@
+#include "spatialHashGrid.h"
+
+int SpatialHashGrid::cellCoord(float value) const
+{
+	return static_cast<int>(std::floor(value / m_cellSize));
+}
+
+uint32_t SpatialHashGrid::bucketOf(int cellX, int cellY, int cellZ) const
+{
+	const uint32_t hash = (static_cast<uint32_t>(cellX) * 73856093u) ^
+		(static_cast<uint32_t>(cellY) * 19349663u) ^
+		(static_cast<uint32_t>(cellZ) * 83492791u);
+	return hash & m_bucketMask;
+}
+
+void SpatialHashGrid::build(const glm::vec3* points, size_t count, float cellSize)
+{
+	m_points = points;
+	m_count = count;
+	m_cellSize = cellSize;
+
+	// roughly two buckets per point keeps collisions rare
+	uint32_t bucketCount = 1;
+	while (bucketCount < count * 2)
+		bucketCount <<= 1;
+	m_bucketMask = bucketCount - 1;
+
+	m_bucketStart.assign(bucketCount + 1, 0);
+	m_pointBucket.resize(count);
+	m_sorted.resize(count);
+
+	for (size_t i = 0; i < count; i++) {
+		const auto& p = points[i];
+		const auto bucket = bucketOf(cellCoord(p.x), cellCoord(p.y), cellCoord(p.z));
+		m_pointBucket[i] = bucket;
+		m_bucketStart[bucket + 1]++;
+	}
+	for (uint32_t b = 0; b < bucketCount; b++)
+		m_bucketStart[b + 1] += m_bucketStart[b];
+
+	// fill back to front so each bucket keeps ascending point order
+	for (size_t i = count; i-- > 0;) {
+		auto& end = m_bucketStart[m_pointBucket[i] + 1];
+		m_sorted[--end] = static_cast<uint32_t>(i);
+	}
+	// the decrements above moved every bucket's end back to its start, so
+	// m_bucketStart[b + 1] now holds where bucket b begins; shift down by one
+	m_bucketStart.erase(m_bucketStart.begin());
+	m_bucketStart.push_back(static_cast<uint32_t>(count));
+}
+
+void SpatialHashGrid::findPairs(float maxDistance, int maxEdgesPerVertex, std::vector<ofIndexType>& indices)
+{
+	const float maxDistanceSquared = maxDistance * maxDistance;
+	m_edgeCount.assign(m_count, 0);
+
+	for (size_t a = 0; a < m_count; a++) {
+		const auto& pa = m_points[a];
+		const int cellX = cellCoord(pa.x);
+		const int cellY = cellCoord(pa.y);
+		const int cellZ = cellCoord(pa.z);
+
+		// neighbouring cells can hash to the same bucket; visit each bucket once
+		uint32_t visited[27];
+		int visitedCount = 0;
+
+		for (int dz = -1; dz <= 1; dz++) {
+			for (int dy = -1; dy <= 1; dy++) {
+				for (int dx = -1; dx <= 1; dx++) {
+					const auto bucket = bucketOf(cellX + dx, cellY + dy, cellZ + dz);
+					if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount)
+						continue;
+					visited[visitedCount++] = bucket;
+
+					for (uint32_t s = m_bucketStart[bucket]; s < m_bucketStart[bucket + 1]; s++) {
+						const uint32_t b = m_sorted[s];
+						if (b <= a)
+							continue;
+						if (maxEdgesPerVertex > 0 && (m_edgeCount[a] >= maxEdgesPerVertex || m_edgeCount[b] >= maxEdgesPerVertex))
+							continue;
+
+						const auto& pb = m_points[b];
+						const float ddx = pa.x - pb.x;
+						const float ddy = pa.y - pb.y;
+						const float ddz = pa.z - pb.z;
+						if (ddx * ddx + ddy * ddy + ddz * ddz <= maxDistanceSquared) {
+							// In OF_PRIMITIVE_LINES, every pair of indices forms a line
+							indices.push_back(static_cast<ofIndexType>(a));
+							indices.push_back(static_cast<ofIndexType>(b));
+							m_edgeCount[a]++;
+							m_edgeCount[b]++;
+						}
+					}
+				}
+			}
+		}
+	}
+}
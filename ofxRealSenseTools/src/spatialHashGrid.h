@@ -0,0 +1,30 @@
+#pragma once
+#include "ofMain.h"
+
+// Uniform grid over 3D points, stored as a spatial hash so that memory only
+// depends on the number of points. Rebuilt every frame in linear time with a
+// counting sort; neighbour queries only visit the 27 cells around a point.
+class SpatialHashGrid
+{
+
+public:
+	void build(const glm::vec3* points, size_t count, float cellSize);
+
+	// Appends an (a, b) index pair for every two points at most maxDistance apart,
+	// ready for OF_PRIMITIVE_LINES. maxDistance must not exceed the cell size.
+	// No point takes part in more than maxEdgesPerVertex pairs (0 = no limit).
+	void findPairs(float maxDistance, int maxEdgesPerVertex, std::vector<ofIndexType>& indices);
+
+private:
+	int cellCoord(float value) const;
+	uint32_t bucketOf(int cellX, int cellY, int cellZ) const;
+
+	const glm::vec3* m_points = nullptr;
+	size_t m_count = 0;
+	float m_cellSize = 1;
+	uint32_t m_bucketMask = 0;
+	std::vector<uint32_t> m_bucketStart; // m_bucketStart[b]..m_bucketStart[b + 1] index m_sorted
+	std::vector<uint32_t> m_sorted;      // point indices grouped by bucket
+	std::vector<uint32_t> m_pointBucket;
+	std::vector<int> m_edgeCount;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Lock-free single producer / single consumer ring of fixed capacity (rounded
+// up to a power of two). push() fails instead of waiting when the ring is
+// full, so the producer never blocks on the consumer.
+template <typename T>
+class SpscQueue
+{
+
+public:
+	explicit SpscQueue(uint32_t capacity)
+	{
+		uint32_t size = 2;
+		while (size < capacity)
+			size *= 2;
+		m_items.resize(size);
+		m_mask = size - 1;
+	}
+
+	// Producer only. Returns false if the ring is full.
+	bool push(const T& item)
+	{
+		const auto tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+			return false;
+		m_items[tail & m_mask] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Returns false if the ring is empty.
+	bool pop(T& item)
+	{
+		const auto head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+		item = m_items[head & m_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	uint32_t getCapacity() const { return m_mask + 1; }
+
+private:
+	std::vector<T> m_items;
+	uint32_t m_mask;
+	std::atomic<uint32_t> m_head{ 0 }; // next to pop, only advanced by the consumer
+	std::atomic<uint32_t> m_tail{ 0 }; // next to push, only advanced by the producer
+};
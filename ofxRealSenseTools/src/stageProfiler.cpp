@@ -0,0 +1,134 @@
+#include "stageProfiler.h"
+#include <fstream>
+#include <iomanip>
+
+namespace {
+	const float frameBudgetMs = 1000.0f / 60.0f;
+	const float barWidth = 120;
+
+	// nearest-rank percentile, partially sorts samples
+	float percentile(std::vector<float>& samples, float fraction)
+	{
+		const size_t rank = std::min(samples.size() - 1, size_t(fraction * samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+		return samples[rank];
+	}
+}
+
+const char* StageProfiler::getStageName(Stage stage)
+{
+	static const char* names[NumStages] = {
+		"capture wait", "downsampling", "depth conversion", "smoothing", "indices", "physics", "upload", "draw", "hud"
+	};
+	return names[stage];
+}
+
+void StageProfiler::addSample(Stage stage, float milliseconds)
+{
+	auto& ring = m_rings[stage];
+	const uint32_t written = ring.written.load(std::memory_order_relaxed);
+	ring.samples[written % sampleCapacity].store(milliseconds, std::memory_order_relaxed);
+	ring.written.store(written + 1, std::memory_order_release);
+}
+
+void StageProfiler::copySamples(Stage stage, std::vector<float>& samples) const
+{
+	const auto& ring = m_rings[stage];
+	const uint32_t written = ring.written.load(std::memory_order_acquire);
+	const uint32_t count = std::min<uint32_t>(written, sampleCapacity);
+	samples.resize(count);
+	// a sample overwritten by the writer during the copy is simply a newer one
+	for (uint32_t i = 0; i < count; i++)
+		samples[i] = ring.samples[(written - count + i) % sampleCapacity].load(std::memory_order_relaxed);
+}
+
+StageProfiler::Percentiles StageProfiler::getPercentiles(Stage stage) const
+{
+	Percentiles result;
+	copySamples(stage, m_scratch);
+	result.count = m_scratch.size();
+	if (m_scratch.empty())
+		return result;
+	result.p50 = percentile(m_scratch, 0.50f);
+	result.p95 = percentile(m_scratch, 0.95f);
+	result.p99 = percentile(m_scratch, 0.99f);
+	return result;
+}
+
+void StageProfiler::draw(float x, float y) const
+{
+	std::stringstream ss;
+	ss << std::left << std::setw(22) << "stage ms (v: csv)" << std::right
+		<< std::setw(6) << "p50" << " " << std::setw(6) << "p95" << " " << std::setw(6) << "p99" << std::endl;
+
+	std::vector<Percentiles> percentiles;
+	std::vector<Stage> stages;
+	for (int i = 0; i < NumStages; i++) {
+		const auto stage = Stage(i);
+		const auto stagePercentiles = getPercentiles(stage);
+		if (stagePercentiles.count == 0)
+			continue;
+		stages.push_back(stage);
+		percentiles.push_back(stagePercentiles);
+		ss << std::left << std::setw(22) << getStageName(stage) << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(6) << stagePercentiles.p50 << " "
+			<< std::setw(6) << stagePercentiles.p95 << " "
+			<< std::setw(6) << stagePercentiles.p99 << std::endl;
+	}
+	ofDrawBitmapStringHighlight(ss.str(), x, y, ofColor::white, ofColor::black);
+
+	// one bar per text line: p50 filled, p95 and p99 as ticks, the full width
+	// being one 60fps frame
+	const float lineHeight = 14;
+	const float barX = x + 43 * 8 + 10;
+	auto barLength = [](float milliseconds) { return barWidth * std::min(1.0f, milliseconds / frameBudgetMs); };
+	ofPushStyle();
+	for (size_t i = 0; i < stages.size(); i++) {
+		const float barY = y + lineHeight * (i + 1) - 9;
+		const auto& p = percentiles[i];
+		ofNoFill();
+		ofSetColor(ofColor::gray);
+		ofDrawRectangle(barX, barY, barWidth, 8);
+		ofFill();
+		ofSetColor(p.p99 > frameBudgetMs ? ofColor::red : ofColor::green);
+		ofDrawRectangle(barX, barY, barLength(p.p50), 8);
+		ofSetColor(ofColor::yellow);
+		ofDrawLine(barX + barLength(p.p95), barY, barX + barLength(p.p95), barY + 8);
+		ofSetColor(ofColor::red);
+		ofDrawLine(barX + barLength(p.p99), barY, barX + barLength(p.p99), barY + 8);
+	}
+	ofPopStyle();
+}
+
+bool StageProfiler::saveCsv(const std::string& path) const
+{
+	std::ofstream out(ofToDataPath(path, true));
+	if (!out)
+		return false;
+
+	out << "stage,sample,milliseconds" << std::endl;
+	std::vector<float> samples;
+	for (int i = 0; i < NumStages; i++) {
+		copySamples(Stage(i), samples);
+		for (size_t sample = 0; sample < samples.size(); sample++)
+			out << getStageName(Stage(i)) << "," << sample << "," << samples[sample] << std::endl;
+	}
+	return bool(out);
+}
+
+//--------------------------------------------------------------
+ScopedStageTimer::ScopedStageTimer(StageProfiler* profiler, StageProfiler::Stage stage)
+	: m_profiler(profiler), m_stage(stage), m_start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedStageTimer::ScopedStageTimer(StageProfiler& profiler, StageProfiler::Stage stage)
+	: ScopedStageTimer(&profiler, stage)
+{
+}
+
+ScopedStageTimer::~ScopedStageTimer()
+{
+	if (m_profiler)
+		m_profiler->addSample(m_stage, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_start).count());
+}
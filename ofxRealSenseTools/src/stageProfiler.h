@@ -0,0 +1,83 @@
+#pragma once
+#include "ofMain.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// Rolling per-stage frame times for finding where a frame budget goes without
+// attaching a profiler. Every stage keeps its last sampleCapacity samples in a
+// lock-free ring; each ring must only be written by one thread (the capture
+// thread for CaptureWait, the Box2D demo's physics thread for Physics, the
+// main thread for the rest), any thread may read.
+// Stages can nest: TriangleMesh's smoothing is also part of its depth conversion.
+class StageProfiler
+{
+
+public:
+	enum Stage {
+		CaptureWait,     // DepthCapture thread blocked on the source
+		Downsampling,    // block pooling of the depth frame
+		DepthConversion, // Z16 samples to vertices / depth grid
+		Smoothing,       // outlier interpolation
+		Indices,         // index generation (connectLines, grid indices)
+		Physics,         // Box2D world step (a whole fixed-rate tick)
+		Upload,          // GridMesh GL uploads
+		Draw,
+		Hud,
+		NumStages
+	};
+
+	static const int sampleCapacity = 600; // 10s at 60fps
+
+	static const char* getStageName(Stage stage);
+
+	void addSample(Stage stage, float milliseconds);
+
+	struct Percentiles
+	{
+		int count = 0;
+		float p50 = 0;
+		float p95 = 0;
+		float p99 = 0;
+	};
+	Percentiles getPercentiles(Stage stage) const;
+
+	// p50/p95/p99 table of every stage that has samples, with a bar per stage
+	// against a 60fps frame budget. Drawn with its top left corner at x, y.
+	void draw(float x, float y) const;
+
+	// Writes every buffered sample, oldest first, as "stage,sample,milliseconds".
+	bool saveCsv(const std::string& path) const;
+
+private:
+	struct SampleRing
+	{
+		std::array<std::atomic<float>, sampleCapacity> samples{};
+		std::atomic<uint32_t> written{ 0 };
+	};
+
+	// Copies the buffered samples of stage, oldest first.
+	void copySamples(Stage stage, std::vector<float>& samples) const;
+
+	std::array<SampleRing, NumStages> m_rings;
+	mutable std::vector<float> m_scratch;
+};
+
+// Adds the time between construction and destruction to a stage. A null
+// profiler makes it a no-op, for code that runs with and without one.
+class ScopedStageTimer
+{
+
+public:
+	ScopedStageTimer(StageProfiler* profiler, StageProfiler::Stage stage);
+	ScopedStageTimer(StageProfiler& profiler, StageProfiler::Stage stage);
+	~ScopedStageTimer();
+
+	ScopedStageTimer(const ScopedStageTimer&) = delete;
+	ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+	StageProfiler* m_profiler;
+	StageProfiler::Stage m_stage;
+	std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,195 @@
+#include "syntheticDepthSource.h"
+#include "ofMain.h"
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+	// The whole of text as a number; false, leaving value alone, if it isn't one.
+	bool parseNumber(const std::string& text, float& value)
+	{
+		char* end = nullptr;
+		const float parsed = std::strtof(text.c_str(), &end);
+		if (text.empty() || *end != '\0')
+			return false;
+		value = parsed;
+		return true;
+	}
+
+	bool parseNumber(const std::string& text, int& value)
+	{
+		char* end = nullptr;
+		const long parsed = std::strtol(text.c_str(), &end, 10);
+		if (text.empty() || *end != '\0' || parsed < INT_MIN || parsed > INT_MAX)
+			return false;
+		value = int(parsed);
+		return true;
+	}
+
+	void logBadToken(const std::string& what, const std::string& token)
+	{
+		ofLogError("SyntheticDepthSource") << "can't parse " << what << " '" << token << "', keeping the default";
+	}
+}
+
+SyntheticDepthSettings parseSyntheticDepthSettings(const std::string& description)
+{
+	SyntheticDepthSettings settings;
+	std::stringstream tokens(description);
+	std::string token;
+	std::getline(tokens, token, ':'); // "synthetic"
+
+	while (std::getline(tokens, token, ':')) {
+		// an @fps suffix may follow any option, or stand alone
+		const size_t at = token.find('@');
+		if (at != std::string::npos) {
+			const std::string fps = token.substr(at + 1);
+			if (!parseNumber(fps, settings.fps) || settings.fps < 0) {
+				logBadToken("frame rate", fps);
+				settings.fps = SyntheticDepthSettings().fps;
+			}
+			token.erase(at);
+			if (token.empty())
+				continue;
+		}
+
+		if (token == "plane")
+			settings.scene = SyntheticDepthSettings::Plane;
+		else if (token == "sphere")
+			settings.scene = SyntheticDepthSettings::Sphere;
+		else if (token == "noise")
+			settings.scene = SyntheticDepthSettings::Noise;
+		else if (token.compare(0, 6, "noise=") == 0) {
+			if (!parseNumber(token.substr(6), settings.noiseAmplitude))
+				logBadToken("noise amplitude", token);
+		}
+		else if (token.compare(0, 8, "dropout=") == 0) {
+			if (!parseNumber(token.substr(8), settings.dropoutRatio))
+				logBadToken("dropout ratio", token);
+		}
+		else if (std::isdigit(static_cast<unsigned char>(token[0]))) {
+			// WxH
+			const size_t x = token.find('x');
+			int width, height;
+			if (x == std::string::npos || !parseNumber(token.substr(0, x), width) || !parseNumber(token.substr(x + 1), height)
+				|| width < 1 || height < 1)
+				logBadToken("resolution", token);
+			else {
+				settings.width = width;
+				settings.height = height;
+			}
+		}
+		else
+			ofLogError("SyntheticDepthSource") << "unknown option '" << token << "'";
+	}
+	return settings;
+}
+
+//--------------------------------------------------------------
+SyntheticDepthSource::SyntheticDepthSource(const SyntheticDepthSettings& settings)
+	: m_settings(settings),
+	// the device needs a frame rate even when frames aren't paced (fps 0)
+	m_device(std::max(1, settings.width), std::max(1, settings.height), std::max(1, settings.fps), settings.depthUnits)
+{
+	m_settings.width = std::max(1, m_settings.width);
+	m_settings.height = std::max(1, m_settings.height);
+	m_settings.fps = std::max(0, m_settings.fps);
+}
+
+void SyntheticDepthSource::start()
+{
+	m_device.start();
+	m_startTime = std::chrono::steady_clock::now();
+	m_nextFrameTime = m_startTime;
+	m_framesRendered = 0;
+}
+
+void SyntheticDepthSource::stop()
+{
+	m_device.stop();
+}
+
+rs2::frame SyntheticDepthSource::waitForFrame(unsigned int timeoutMs)
+{
+	if (m_settings.fps > 0) {
+		const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+		if (m_nextFrameTime > timeout) {
+			std::this_thread::sleep_until(timeout);
+			return rs2::frame();
+		}
+		std::this_thread::sleep_until(m_nextFrameTime);
+		m_nextFrameTime += std::chrono::microseconds(1000000 / m_settings.fps);
+	}
+
+	// with a frame rate the scene advances in fixed steps, otherwise with the wall clock
+	const double seconds = m_settings.fps > 0 ?
+		double(m_framesRendered) / m_settings.fps :
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	m_framesRendered++;
+
+	auto pixels = m_device.allocatePixels();
+	render(pixels, seconds);
+	return m_device.publish(pixels, seconds * 1000.0);
+}
+
+std::string SyntheticDepthSource::getDescription() const
+{
+	const char* scenes[] = { "plane", "sphere", "noise" };
+	return std::string("synthetic:") + scenes[m_settings.scene] + ":" +
+		ofToString(m_settings.width) + "x" + ofToString(m_settings.height) + "@" + ofToString(m_settings.fps);
+}
+
+float SyntheticDepthSource::sceneDistance(int x, int y, double seconds) const
+{
+	const float width = m_settings.width;
+	const float height = m_settings.height;
+	const float u = x / width;
+	const float v = y / height;
+	const float t = static_cast<float>(seconds);
+
+	switch (m_settings.scene) {
+	case SyntheticDepthSettings::Plane:
+		// wall between 0.6 and 1.8m, its tilt swinging over ~6 seconds
+		return 1.2f + 0.6f * std::sin(t) * (u - 0.5f) * 2.0f + 0.2f * (v - 0.5f);
+
+	case SyntheticDepthSettings::Sphere: {
+		const float wall = 1.8f;
+		const float radius = 0.25f * height;
+		const float centerX = width * (0.5f + 0.3f * std::sin(t));
+		const float centerY = height * 0.5f;
+		const float dx = x - centerX;
+		const float dy = y - centerY;
+		const float inside = radius * radius - dx * dx - dy * dy;
+		if (inside <= 0)
+			return wall;
+		// front of a 0.4m ball whose centre sits 1.0m away
+		return 1.0f - 0.4f * std::sqrt(inside) / radius;
+	}
+
+	case SyntheticDepthSettings::Noise:
+	default:
+		return 0.4f + 1.4f * ofNoise(u * 4.0f, v * 4.0f, t * 0.25f);
+	}
+}
+
+void SyntheticDepthSource::render(uint16_t* pixels, double seconds)
+{
+	std::uniform_real_distribution<float> jitter(-m_settings.noiseAmplitude, m_settings.noiseAmplitude);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	const float rawPerMetre = 1.0f / m_settings.depthUnits;
+
+	for (int y = 0; y < m_settings.height; y++) {
+		uint16_t* row = pixels + y * m_settings.width;
+		for (int x = 0; x < m_settings.width; x++) {
+			if (m_settings.dropoutRatio > 0 && chance(m_random) < m_settings.dropoutRatio) {
+				row[x] = 0;
+				continue;
+			}
+			float distance = sceneDistance(x, y, seconds);
+			if (m_settings.noiseAmplitude > 0)
+				distance += jitter(m_random);
+			row[x] = static_cast<uint16_t>(ofClamp(distance * rawPerMetre, 0, 65535));
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "depthSource.h"
+#include "softwareDepthDevice.h"
+#include <chrono>
+#include <random>
+
+struct SyntheticDepthSettings
+{
+	enum Scene { Plane, Sphere, Noise };
+
+	Scene scene = Sphere;
+	int width = 848;
+	int height = 480;
+	int fps = 30;                 // 0 = as fast as frames are consumed
+	float depthUnits = 0.001f;    // metres per Z16 step, same as the D400 default
+	float noiseAmplitude = 0.005f; // per-pixel jitter in metres
+	float dropoutRatio = 0.02f;   // fraction of pixels reported as 0 (no data)
+};
+
+// "synthetic[:plane|sphere|noise][:WxH][@fps][:noise=m][:dropout=r]"; the
+// @fps suffix may follow any option (synthetic:sphere@60) or stand alone
+// (synthetic:@60). Malformed values are logged and keep their defaults.
+SyntheticDepthSettings parseSyntheticDepthSettings(const std::string& description);
+
+// Procedurally generated depth frames for running without a camera:
+//   Plane  - a wall tilting slowly back and forth
+//   Sphere - a ball moving side to side in front of a wall
+//   Noise  - smooth Perlin terrain drifting over time
+// On top of the scene every pixel gets noiseAmplitude jitter, and dropoutRatio
+// of the pixels are zeroed like the holes a real sensor reports.
+class SyntheticDepthSource : public DepthSource
+{
+
+public:
+	explicit SyntheticDepthSource(const SyntheticDepthSettings& settings);
+
+	void start() override;
+	void stop() override;
+	rs2::frame waitForFrame(unsigned int timeoutMs) override;
+	std::string getDescription() const override;
+
+	// Fills pixels (width * height samples) with the scene at time seconds.
+	void render(uint16_t* pixels, double seconds);
+
+private:
+	float sceneDistance(int x, int y, double seconds) const;
+
+	SyntheticDepthSettings m_settings;
+	SoftwareDepthDevice m_device;
+	std::mt19937 m_random;
+	std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_nextFrameTime;
+	int m_framesRendered = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer.
+// The writer always owns one slot, the reader owns another and the third
+// ("middle") slot is swapped between them. Publishing over a slot the reader
+// has not picked up yet simply replaces it, so the reader always gets the
+// newest value and never waits on the writer.
+template <typename T>
+class TripleBuffer
+{
+
+public:
+	TripleBuffer() : m_middle(1), m_writeIndex(0), m_readIndex(2) {}
+
+	// Slot the producer may fill before calling publish().
+	T& getWriteBuffer() { return m_buffers[m_writeIndex]; }
+
+	// Hands the write slot to the reader. Returns true if a value the reader
+	// never saw was overwritten.
+	bool publish()
+	{
+		const auto previous = m_middle.exchange(m_writeIndex | freshFlag, std::memory_order_acq_rel);
+		m_writeIndex = previous & indexMask;
+		return (previous & freshFlag) != 0;
+	}
+
+	// Swaps the newest published value into the read slot. Returns false if
+	// nothing was published since the last successful call.
+	bool fetch()
+	{
+		if ((m_middle.load(std::memory_order_acquire) & freshFlag) == 0)
+			return false;
+		const auto previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+		m_readIndex = previous & indexMask;
+		return true;
+	}
+
+	T& getReadBuffer() { return m_buffers[m_readIndex]; }
+	const T& getReadBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+	static const uint8_t indexMask = 0x3;
+	static const uint8_t freshFlag = 0x4;
+
+	std::array<T, 3> m_buffers;
+	std::atomic<uint8_t> m_middle; // index of the shared slot, plus freshFlag
+	uint8_t m_writeIndex; // only touched by the producer
+	uint8_t m_readIndex;  // only touched by the consumer
+};
@@ -0,0 +1,101 @@
+#include "vertexLabels.h"
+#include <cstdio>
+
+const int VertexLabels::slotSize;
+
+namespace {
+	const char firstGlyph = ' ';
+	const char lastGlyph = '~';
+	const float glyphAdvance = 8; // ofBitmapFont is fixed width
+	const glm::vec2 labelOffset(4, -4); // from the vertex, in pixels
+}
+
+void VertexLabels::update(const glm::vec3* vertices, int count)
+{
+	if (int(m_positions.size()) != count) {
+		// NaN never compares equal, so every label gets formatted below
+		m_positions.assign(count, glm::vec3(NAN, NAN, NAN));
+		m_text.resize(count * slotSize);
+		m_lengths.assign(count, 0);
+	}
+
+	for (int i = 0; i < count; i++) {
+		const glm::vec3& vertex = vertices[i];
+		if (vertex == m_positions[i])
+			continue;
+		m_positions[i] = vertex;
+		// %g prints what the former stringstream label did
+		const int length = std::snprintf(&m_text[i * slotSize], slotSize, "%d:%g,%g,%g", i, vertex.x, vertex.y, vertex.z);
+		m_lengths[i] = uint8_t(ofClamp(length, 0, slotSize - 1));
+	}
+}
+
+void VertexLabels::loadGlyphs()
+{
+	// one character at a time out of ofBitmapFont, so glyph quads can be copied
+	// instead of asking it for a mesh per label
+	m_glyphs.resize(lastGlyph - firstGlyph + 1);
+	for (char c = firstGlyph; c <= lastGlyph; c++) {
+		const ofMesh& mesh = m_font.getMesh(std::string(1, c), 0, 0, OF_BITMAPMODE_SIMPLE, true);
+		auto& glyph = m_glyphs[c - firstGlyph];
+		glyph.vertices = mesh.getVertices();
+		glyph.texCoords = mesh.getTexCoords();
+	}
+	m_batch.setMode(OF_PRIMITIVE_TRIANGLES);
+}
+
+void VertexLabels::layout(float maxDistance)
+{
+	if (m_glyphs.empty())
+		loadGlyphs();
+
+	const glm::mat4 modelView = ofGetCurrentMatrix(OF_MATRIX_MODELVIEW);
+	const glm::mat4 projection = ofGetCurrentMatrix(OF_MATRIX_PROJECTION);
+	const ofRectangle viewport = ofGetCurrentViewport();
+
+	auto& vertices = m_batch.getVertices();
+	auto& texCoords = m_batch.getTexCoords();
+	vertices.clear();
+	texCoords.clear();
+	m_numVisible = 0;
+
+	for (int i = 0; i < int(m_positions.size()); i++) {
+		const glm::vec4 eye = modelView * glm::vec4(m_positions[i], 1);
+		if (glm::length(glm::vec3(eye)) > maxDistance)
+			continue;
+		const glm::vec4 clip = projection * eye;
+		if (clip.w <= 0)
+			continue; // behind the camera
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		if (std::abs(ndc.x) > 1 || std::abs(ndc.y) > 1 || std::abs(ndc.z) > 1)
+			continue;
+
+		m_numVisible++;
+		glm::vec3 pen(
+			viewport.x + (ndc.x + 1) * 0.5f * viewport.width + labelOffset.x,
+			viewport.y + (1 - ndc.y) * 0.5f * viewport.height + labelOffset.y,
+			0);
+		const char* text = &m_text[i * slotSize];
+		for (int c = 0; c < m_lengths[i]; c++, pen.x += glyphAdvance) {
+			if (text[c] < firstGlyph || text[c] > lastGlyph)
+				continue;
+			const auto& glyph = m_glyphs[text[c] - firstGlyph];
+			for (const auto& vertex : glyph.vertices)
+				vertices.push_back(vertex + pen);
+			texCoords.insert(texCoords.end(), glyph.texCoords.begin(), glyph.texCoords.end());
+		}
+	}
+}
+
+void VertexLabels::draw() const
+{
+	if (m_batch.getNumVertices() == 0)
+		return;
+	ofPushStyle();
+	ofEnableAlphaBlending();
+	ofSetColor(ofColor::white);
+	m_font.getTexture().bind();
+	m_batch.draw();
+	m_font.getTexture().unbind();
+	ofPopStyle();
+}
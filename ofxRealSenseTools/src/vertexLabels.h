@@ -0,0 +1,46 @@
+#pragma once
+#include "ofMain.h"
+
+// "index:x,y,z" labels next to the vertices of a mesh, drawn as a single
+// batch of bitmap font glyph quads. A label's text is only re-formatted when
+// its vertex moved, into a fixed slot of a reusable character buffer; each
+// frame the labels whose vertex is on screen and near the camera are laid out
+// in screen space next to it.
+class VertexLabels
+{
+
+public:
+	// Takes the current vertex positions, re-formatting the labels of the ones
+	// that changed.
+	void update(const glm::vec3* vertices, int count);
+
+	// Lays out the glyphs of every visible label. Call it between
+	// ofCamera::begin() and end(), with the transform the vertices are drawn
+	// with applied: labels whose vertex is outside the view or further than
+	// maxDistance from the camera are left out.
+	void layout(float maxDistance);
+
+	// Draws the laid out glyphs, in one call, in screen space (after ofCamera::end()).
+	void draw() const;
+
+	int getNumVisible() const { return m_numVisible; }
+
+private:
+	static const int slotSize = 48; // bytes per label, "-2147483648:-1.23457e+06,..." fits
+
+	void loadGlyphs();
+
+	std::vector<glm::vec3> m_positions; // as formatted
+	std::vector<char> m_text;           // slotSize bytes per label
+	std::vector<uint8_t> m_lengths;
+
+	ofBitmapFont m_font;
+	struct Glyph
+	{
+		std::vector<glm::vec3> vertices; // relative to the character's pen position
+		std::vector<glm::vec2> texCoords;
+	};
+	std::vector<Glyph> m_glyphs; // per printable ASCII character from ' '
+	ofMesh m_batch;
+	int m_numVisible = 0;
+};
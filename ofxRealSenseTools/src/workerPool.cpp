@@ -0,0 +1,75 @@
+#include "workerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < numThreads; i++)
+		m_workers.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int)>& task)
+{
+	if (count <= 0)
+		return;
+	if (m_workers.empty() || count == 1) {
+		for (int i = 0; i < count; i++)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_taskCount = count;
+		m_nextTask = 0;
+		m_busyWorkers = int(m_workers.size());
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	runTasks();
+
+	// every worker has to check out before task goes out of scope
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_busyWorkers == 0; });
+	m_task = nullptr;
+}
+
+void WorkerPool::runTasks()
+{
+	for (int i = m_nextTask++; i < m_taskCount; i = m_nextTask++)
+		(*m_task)(i);
+}
+
+void WorkerPool::workerLoop()
+{
+	uint64_t generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_generation != generation; });
+			if (m_quit)
+				return;
+			generation = m_generation;
+		}
+
+		runTasks();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busyWorkers == 0)
+			m_done.notify_one();
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting per-frame loops into
+// independent pieces. parallelFor() hands out task indices to the workers and
+// the calling thread alike and returns once every task has run, so the
+// caller can treat it like an ordinary (blocking) loop.
+class WorkerPool
+{
+
+public:
+	// numThreads counts the calling thread too; 0 uses every hardware thread.
+	explicit WorkerPool(int numThreads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	int getNumThreads() const { return int(m_workers.size()) + 1; }
+
+	// Runs task(0) .. task(count - 1), in any order and on any thread.
+	// Not reentrant: task must not call parallelFor() on the same pool.
+	void parallelFor(int count, const std::function<void(int)>& task);
+
+private:
+	void workerLoop();
+	void runTasks();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	const std::function<void(int)>* m_task = nullptr;
+	int m_taskCount = 0;
+	std::atomic<int> m_nextTask{ 0 };
+	int m_busyWorkers = 0;
+	uint64_t m_generation = 0;
+	bool m_quit = false;
+};